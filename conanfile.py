@@ -13,8 +13,10 @@ class CppSQLite(ConanFile):
     topics = ("sqlite", "database", "cpp20", "boost")
 
     settings = "os", "compiler", "build_type", "arch"
-    options = {"shared": [True, False], "fPIC": [True, False], "build_testing": [True, False]}
-    default_options = {"shared": False, "fPIC": True, "build_testing": False}
+    options = {"shared": [True, False], "fPIC": [True, False], "build_testing": [True, False],
+               "build_benchmarks": [True, False]}
+    default_options = {"shared": False, "fPIC": True, "build_testing": False,
+                       "build_benchmarks": False}
 
     # Sources are located in the same place as this recipe, copy them to the recipe
     # Include source files for debugging support
@@ -64,6 +66,9 @@ class CppSQLite(ConanFile):
         if self.options.build_testing:
             tc.variables["BUILD_TESTING"] = "ON"
 
+        if self.options.build_benchmarks:
+            tc.variables["BUILD_BENCHMARKS"] = "ON"
+
         tc.generate()
 
     def build(self):
@@ -92,6 +97,8 @@ class CppSQLite(ConanFile):
         self.requires('spdlog/1.14.1')
         # Test-only dependency
         self.test_requires("gtest/1.14.0")
+        if self.options.build_benchmarks:
+            self.test_requires("benchmark/1.8.3")
 
     def build_requirements(self):
         self.tool_requires("cmake/3.22.6")
@@ -0,0 +1,469 @@
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <ranges>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "cpp_sqlite/src/cpp_sqlite/DBDataAccessObject.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBDatabase.hpp"
+#include "cpp_sqlite/test/testTransferObjects.hpp"
+
+namespace
+{
+//! The database file used by the on-disk runs
+constexpr const char* kBenchDbFile = "cpp_sqlite_bench.db";
+
+//! The number of children of every TestProduct
+constexpr uint32_t kChildrenPerProduct = 4;
+
+//! The slots of the lock-free buffer in the contended benchmark. Every
+//! thread adds kRowsPerThread rows, so the buffer never fills up.
+constexpr std::size_t kContendedCapacity = std::size_t{1} << 20;
+constexpr benchmark::IterationCount kRowsPerThread = kContendedCapacity / 8;
+
+/*!
+ * \brief Open an empty database for a benchmark run
+ *
+ * The first benchmark argument selects the storage: 0 for an in-memory
+ * database, 1 for a database file that is removed first.
+ */
+std::unique_ptr<cpp_sqlite::Database> openDatabase(benchmark::State& state)
+{
+  const bool onDisk = state.range(0) != 0;
+  state.SetLabel(onDisk ? "file" : "memory");
+
+  if (!onDisk)
+  {
+    return std::make_unique<cpp_sqlite::Database>(":memory:", true);
+  }
+
+  for (const char* suffix : {"", "-journal", "-wal", "-shm"})
+  {
+    std::filesystem::remove(std::string{kBenchDbFile} + suffix);
+  }
+  return std::make_unique<cpp_sqlite::Database>(kBenchDbFile, true);
+}
+
+Vertex3D makeVertex(uint32_t id)
+{
+  Vertex3D vertex;
+  vertex.id = id;
+  vertex.x = static_cast<float>(id);
+  vertex.y = static_cast<float>(id) * 0.5f;
+  vertex.z = static_cast<float>(id) * 0.25f;
+  return vertex;
+}
+
+/*!
+ * \brief Make a rigid body whose center of mass refers to the vertex with
+ *        the same identifier
+ *
+ * The nested position is left without an identifier, so the vertex DAO
+ * assigns one after the vertices that already exist.
+ */
+RigidBody makeBody(uint32_t id)
+{
+  RigidBody body;
+  body.id = id;
+  body.name = "body_" + std::to_string(id);
+  body.mass = static_cast<float>(id);
+  body.centerOfMass.id = id;
+  body.initialPosition = makeVertex(id);
+  body.initialPosition.id = cpp_sqlite::BaseTransferObject{}.id;
+  return body;
+}
+
+TestProduct makeProduct(uint32_t id)
+{
+  TestProduct product;
+  product.id = id;
+  product.name = "product_" + std::to_string(id);
+  product.price = static_cast<float>(id);
+  product.quantity = static_cast<int>(id);
+  product.in_stock = (id % 2) == 0;
+  for (uint32_t i = 0; i < kChildrenPerProduct; i++)
+  {
+    ChildProduct child;
+    child.id = (id - 1) * kChildrenPerProduct + i + 1;
+    child.price = static_cast<double>(child.id);
+    product.children.data.push_back(child);
+  }
+  return product;
+}
+
+template <typename T>
+T makeRow(uint32_t id)
+{
+  if constexpr (std::is_same_v<T, Vertex3D>)
+  {
+    return makeVertex(id);
+  }
+  else if constexpr (std::is_same_v<T, RigidBody>)
+  {
+    return makeBody(id);
+  }
+  else
+  {
+    return makeProduct(id);
+  }
+}
+
+/*!
+ * \brief Check that a flush committed the expected number of rows, and
+ *        skip the benchmark if it did not
+ */
+bool checkFlush(const cpp_sqlite::FlushResult& result,
+                uint32_t expected,
+                benchmark::State& state)
+{
+  if (result.ok() && result.succeeded == expected)
+  {
+    return true;
+  }
+
+  state.SkipWithError("Populating the database failed");
+  return false;
+}
+
+/*!
+ * \brief Check that a table holds the expected number of rows, and skip
+ *        the benchmark if it does not
+ */
+template <typename T>
+bool checkRowCount(cpp_sqlite::Database& db,
+                   std::size_t expected,
+                   benchmark::State& state)
+{
+  if (db.getDAO<T>().selectAll().size() == expected)
+  {
+    return true;
+  }
+
+  state.SkipWithError("The populated table has the wrong row count");
+  return false;
+}
+
+/*!
+ * \brief Insert rows 1..rowCount with one buffered flush
+ *
+ * Rigid bodies also get the vertices their centers of mass refer to. They
+ * are inserted first, as vertices 1..rowCount, so that every key of the
+ * resolve benchmarks hits a row.
+ *
+ * \return False, with the benchmark skipped, if any row is missing
+ */
+template <typename T>
+bool populate(cpp_sqlite::Database& db,
+              uint32_t rowCount,
+              benchmark::State& state)
+{
+  if constexpr (std::is_same_v<T, RigidBody>)
+  {
+    auto& vertexDAO = db.getDAO<Vertex3D>();
+    vertexDAO.reserveBuffer(rowCount);
+    for (uint32_t id = 1; id <= rowCount; id++)
+    {
+      vertexDAO.addToBuffer(makeVertex(id));
+    }
+    if (!checkFlush(vertexDAO.insert(), rowCount, state))
+    {
+      return false;
+    }
+  }
+
+  auto& dao = db.getDAO<T>();
+  dao.reserveBuffer(rowCount);
+  for (uint32_t id = 1; id <= rowCount; id++)
+  {
+    dao.addToBuffer(makeRow<T>(id));
+  }
+  if (!checkFlush(dao.insert(), rowCount, state) ||
+      !checkRowCount<T>(db, rowCount, state))
+  {
+    return false;
+  }
+
+  if constexpr (std::is_same_v<T, RigidBody>)
+  {
+    // The centers of mass and the nested positions
+    return checkRowCount<Vertex3D>(db, 2 * std::size_t{rowCount}, state);
+  }
+  else
+  {
+    return true;
+  }
+}
+
+/*!
+ * \brief Drop the objects the bodies' centers of mass were resolved to
+ */
+void unresolve(std::vector<RigidBody>& bodies)
+{
+  for (auto& body : bodies)
+  {
+    body.centerOfMass.data_.reset();
+  }
+}
+
+/*!
+ * \brief Check that every center of mass refers to an existing vertex, so
+ *        that the resolve benchmarks measure hits, and skip the benchmark
+ *        if one does not
+ */
+bool checkResolvable(cpp_sqlite::Database& db,
+                     std::vector<RigidBody>& bodies,
+                     benchmark::State& state)
+{
+  const std::size_t resolved = cpp_sqlite::resolveAll(
+    bodies | std::views::transform(&RigidBody::centerOfMass), db);
+  unresolve(bodies);
+  if (resolved == bodies.size())
+  {
+    return true;
+  }
+
+  state.SkipWithError("A center of mass refers to a missing vertex");
+  return false;
+}
+}  // namespace
+
+// One autocommitted INSERT per row
+template <typename T>
+static void BM_InsertSingle(benchmark::State& state)
+{
+  auto pDB = openDatabase(state);
+  auto& dao = pDB->getDAO<T>();
+
+  uint32_t id = 1;
+  for (auto _ : state)
+  {
+    T row = makeRow<T>(id++);
+    benchmark::DoNotOptimize(dao.insert(row));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Buffer range(1) rows and flush them in one transaction
+template <typename T>
+static void BM_InsertBuffered(benchmark::State& state)
+{
+  auto pDB = openDatabase(state);
+  auto& dao = pDB->getDAO<T>();
+  const auto batchSize = static_cast<uint32_t>(state.range(1));
+  dao.reserveBuffer(batchSize);
+
+  uint32_t id = 1;
+  for (auto _ : state)
+  {
+    for (uint32_t i = 0; i < batchSize; i++)
+    {
+      dao.addToBuffer(makeRow<T>(id++));
+    }
+    benchmark::DoNotOptimize(dao.insert().succeeded);
+  }
+  state.SetItemsProcessed(state.iterations() * batchSize);
+}
+
+template <typename T>
+static void BM_SelectAll(benchmark::State& state)
+{
+  auto pDB = openDatabase(state);
+  const auto rowCount = static_cast<uint32_t>(state.range(1));
+  if (!populate<T>(*pDB, rowCount, state))
+  {
+    return;
+  }
+  auto& dao = pDB->getDAO<T>();
+
+  for (auto _ : state)
+  {
+    auto rows = dao.selectAll();
+    benchmark::DoNotOptimize(rows.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rowCount);
+}
+
+template <typename T>
+static void BM_SelectById(benchmark::State& state)
+{
+  auto pDB = openDatabase(state);
+  const auto rowCount = static_cast<uint32_t>(state.range(1));
+  if (!populate<T>(*pDB, rowCount, state))
+  {
+    return;
+  }
+  auto& dao = pDB->getDAO<T>();
+
+  uint32_t id = 0;
+  for (auto _ : state)
+  {
+    auto row = dao.selectById(id % rowCount + 1);
+    benchmark::DoNotOptimize(row);
+    id++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Resolve the centers of mass of range(1) bodies with cold caches, either
+// in batches through resolveAll() or with one resolve() per key
+static void BM_ResolveAll(benchmark::State& state)
+{
+  auto pDB = openDatabase(state);
+  const auto rowCount = static_cast<uint32_t>(state.range(1));
+  if (!populate<RigidBody>(*pDB, rowCount, state))
+  {
+    return;
+  }
+  auto& vertexDAO = pDB->getDAO<Vertex3D>();
+  auto bodies = pDB->getDAO<RigidBody>().selectAll();
+  if (!checkResolvable(*pDB, bodies, state))
+  {
+    return;
+  }
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    vertexDAO.clearCache();
+    unresolve(bodies);
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(cpp_sqlite::resolveAll(
+      bodies | std::views::transform(&RigidBody::centerOfMass), *pDB));
+  }
+  state.SetItemsProcessed(state.iterations() * rowCount);
+}
+
+static void BM_ResolveEach(benchmark::State& state)
+{
+  auto pDB = openDatabase(state);
+  const auto rowCount = static_cast<uint32_t>(state.range(1));
+  if (!populate<RigidBody>(*pDB, rowCount, state))
+  {
+    return;
+  }
+  auto& vertexDAO = pDB->getDAO<Vertex3D>();
+  auto bodies = pDB->getDAO<RigidBody>().selectAll();
+  if (!checkResolvable(*pDB, bodies, state))
+  {
+    return;
+  }
+
+  for (auto _ : state)
+  {
+    state.PauseTiming();
+    vertexDAO.clearCache();
+    unresolve(bodies);
+    state.ResumeTiming();
+
+    for (auto& body : bodies)
+    {
+      benchmark::DoNotOptimize(body.centerOfMass.resolve(*pDB));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * rowCount);
+}
+
+// Producers racing on addToBuffer(); range(1) selects the buffer backend
+// (0 for the mutex-guarded vector, 1 for the lock-free ring buffer)
+static void BM_AddToBufferContended(benchmark::State& state)
+{
+  static std::unique_ptr<cpp_sqlite::Database> pDB;
+  const bool lockFree = state.range(1) != 0;
+
+  if (state.thread_index() == 0)
+  {
+    pDB = openDatabase(state);
+    auto& dao = pDB->getDAO<Vertex3D>();
+    if (lockFree)
+    {
+      dao.setBufferBackend(cpp_sqlite::BufferBackend::LockFree,
+                           kContendedCapacity,
+                           cpp_sqlite::BufferFullPolicy::Block);
+    }
+    else
+    {
+      dao.reserveBuffer(kContendedCapacity);
+    }
+  }
+
+  // The benchmark library starts every thread's loop together, after
+  // thread 0 has finished the setup above
+  auto id = static_cast<uint32_t>(state.thread_index() * kRowsPerThread + 1);
+  for (auto _ : state)
+  {
+    benchmark::DoNotOptimize(
+      pDB->getDAO<Vertex3D>().addToBuffer(makeVertex(id++)));
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetLabel(lockFree ? "lock-free" : "mutex");
+
+  if (state.thread_index() == 0)
+  {
+    pDB->getDAO<Vertex3D>().clearBuffer();
+    pDB.reset();
+  }
+}
+
+// Every benchmark runs against an in-memory database (storage 0) and a
+// database file (storage 1)
+constexpr int64_t kRows = 1000;
+
+BENCHMARK_TEMPLATE(BM_InsertSingle, Vertex3D)
+  ->ArgName("storage")
+  ->DenseRange(0, 1);
+BENCHMARK_TEMPLATE(BM_InsertSingle, RigidBody)
+  ->ArgName("storage")
+  ->DenseRange(0, 1);
+BENCHMARK_TEMPLATE(BM_InsertSingle, TestProduct)
+  ->ArgName("storage")
+  ->DenseRange(0, 1);
+
+BENCHMARK_TEMPLATE(BM_InsertBuffered, Vertex3D)
+  ->ArgNames({"storage", "batch"})
+  ->ArgsProduct({{0, 1}, {100, kRows}});
+BENCHMARK_TEMPLATE(BM_InsertBuffered, RigidBody)
+  ->ArgNames({"storage", "batch"})
+  ->ArgsProduct({{0, 1}, {100, kRows}});
+BENCHMARK_TEMPLATE(BM_InsertBuffered, TestProduct)
+  ->ArgNames({"storage", "batch"})
+  ->ArgsProduct({{0, 1}, {100, kRows}});
+
+BENCHMARK_TEMPLATE(BM_SelectAll, Vertex3D)
+  ->ArgNames({"storage", "rows"})
+  ->ArgsProduct({{0, 1}, {kRows}});
+BENCHMARK_TEMPLATE(BM_SelectAll, RigidBody)
+  ->ArgNames({"storage", "rows"})
+  ->ArgsProduct({{0, 1}, {kRows}});
+BENCHMARK_TEMPLATE(BM_SelectAll, TestProduct)
+  ->ArgNames({"storage", "rows"})
+  ->ArgsProduct({{0, 1}, {kRows}});
+
+BENCHMARK_TEMPLATE(BM_SelectById, Vertex3D)
+  ->ArgNames({"storage", "rows"})
+  ->ArgsProduct({{0, 1}, {kRows}});
+BENCHMARK_TEMPLATE(BM_SelectById, RigidBody)
+  ->ArgNames({"storage", "rows"})
+  ->ArgsProduct({{0, 1}, {kRows}});
+BENCHMARK_TEMPLATE(BM_SelectById, TestProduct)
+  ->ArgNames({"storage", "rows"})
+  ->ArgsProduct({{0, 1}, {kRows}});
+
+BENCHMARK(BM_ResolveAll)
+  ->ArgNames({"storage", "rows"})
+  ->ArgsProduct({{0, 1}, {kRows}});
+BENCHMARK(BM_ResolveEach)
+  ->ArgNames({"storage", "rows"})
+  ->ArgsProduct({{0, 1}, {kRows}});
+
+BENCHMARK(BM_AddToBufferContended)
+  ->ArgNames({"storage", "lockfree"})
+  ->ArgsProduct({{0, 1}, {0, 1}})
+  ->Iterations(kRowsPerThread)
+  ->ThreadRange(1, 8)
+  ->UseRealTime();
+
+BENCHMARK_MAIN();
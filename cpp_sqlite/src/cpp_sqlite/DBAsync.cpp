@@ -0,0 +1,155 @@
+#include "cpp_sqlite/src/cpp_sqlite/DBAsync.hpp"
+
+#include <algorithm>
+
+namespace cpp_sqlite
+{
+
+ThreadPoolExecutor::ThreadPoolExecutor(std::size_t threadCount,
+                                       std::shared_ptr<spdlog::logger> pLogger)
+  : mutex_{}, wakeWorker_{}, queue_{}, stopping_{false}, pLogger_{pLogger}
+{
+  threadCount = std::max<std::size_t>(threadCount, 1);
+  threads_.reserve(threadCount);
+  for (std::size_t i = 0; i < threadCount; ++i)
+  {
+    threads_.emplace_back(&ThreadPoolExecutor::run, this);
+  }
+
+  LOG_SAFE(pLogger_,
+           spdlog::level::debug,
+           "Started async executor with {} threads",
+           threadCount);
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wakeWorker_.notify_all();
+
+  for (auto& thread : threads_)
+  {
+    thread.join();
+  }
+}
+
+void ThreadPoolExecutor::execute(std::function<void()> work)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(work));
+  }
+  wakeWorker_.notify_one();
+}
+
+Executor ThreadPoolExecutor::executor()
+{
+  return [this](std::function<void()> work) { execute(std::move(work)); };
+}
+
+void ThreadPoolExecutor::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  while (true)
+  {
+    wakeWorker_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+
+    if (queue_.empty())
+    {
+      // Only reached when stopping, after the queue has been drained
+      break;
+    }
+
+    std::function<void()> work = std::move(queue_.front());
+    queue_.pop_front();
+
+    lock.unlock();
+    try
+    {
+      work();
+    }
+    catch (const std::exception& ex)
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "Async executor work threw: {}",
+               ex.what());
+    }
+    catch (...)
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "Async executor work threw an unknown exception");
+    }
+    lock.lock();
+  }
+}
+
+Strand::Strand(Executor executor)
+  : executor_{std::move(executor)}, mutex_{}, queue_{}, running_{false}
+{
+}
+
+void Strand::execute(std::function<void()> work)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(work));
+    if (running_)
+    {
+      // Picked up by scheduleNext() once the running work is done
+      return;
+    }
+    running_ = true;
+  }
+
+  executor_([self = shared_from_this()] { self->runNext(); });
+}
+
+Executor Strand::executor()
+{
+  return [self = shared_from_this()](std::function<void()> work)
+  { self->execute(std::move(work)); };
+}
+
+void Strand::runNext()
+{
+  std::function<void()> work;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    work = std::move(queue_.front());
+    queue_.pop_front();
+  }
+
+  try
+  {
+    work();
+  }
+  catch (...)
+  {
+    // The rest of the queue still runs; the executor handles the error
+    scheduleNext();
+    throw;
+  }
+  scheduleNext();
+}
+
+void Strand::scheduleNext()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty())
+    {
+      running_ = false;
+      return;
+    }
+  }
+
+  executor_([self = shared_from_this()] { self->runNext(); });
+}
+
+}  // namespace cpp_sqlite
@@ -0,0 +1,305 @@
+#ifndef DB_ASYNC_HPP
+#define DB_ASYNC_HPP
+
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "cpp_sqlite/src/utils/Logger.hpp"
+
+namespace cpp_sqlite
+{
+
+/*!
+ * \brief Runs a piece of work, typically by posting it to a thread
+ *
+ * Any event loop can be adapted, for example
+ * `[&](auto work) { asio::post(ioContext, std::move(work)); }`.
+ */
+using Executor = std::function<void(std::function<void()>)>;
+
+/*!
+ * \brief A fixed set of threads that run queued work in order
+ */
+class ThreadPoolExecutor
+{
+public:
+  /*!
+   * \brief Start the worker threads
+   * \param threadCount The number of worker threads (at least one)
+   * \param pLogger Optional logger
+   */
+  explicit ThreadPoolExecutor(std::size_t threadCount,
+                              std::shared_ptr<spdlog::logger> pLogger = nullptr);
+
+  /*!
+   * \brief Run the queued work and join the worker threads
+   */
+  ~ThreadPoolExecutor();
+
+  ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+  ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+  ThreadPoolExecutor(ThreadPoolExecutor&&) = delete;
+  ThreadPoolExecutor& operator=(ThreadPoolExecutor&&) = delete;
+
+  /*!
+   * \brief Queue work to run on one of the worker threads
+   *
+   * Work that throws is logged and otherwise ignored.
+   */
+  void execute(std::function<void()> work);
+
+  /*!
+   * \brief Get an Executor that queues work on this pool
+   */
+  Executor executor();
+
+private:
+  /*!
+   * \brief The worker thread main loop
+   */
+  void run();
+
+  //! Guards the queue and the stop flag
+  std::mutex mutex_;
+
+  //! Wakes the worker threads
+  std::condition_variable wakeWorker_;
+
+  //! Work waiting to run
+  std::deque<std::function<void()>> queue_;
+
+  //! Set when the workers should exit once the queue is empty
+  bool stopping_;
+
+  //! The local logger
+  std::shared_ptr<spdlog::logger> pLogger_;
+
+  //! The worker threads (declared last so they start after the state
+  //! above)
+  std::vector<std::thread> threads_;
+};
+
+/*!
+ * \brief Runs work on an executor one piece at a time, in order
+ *
+ * Work posted through a strand never runs concurrently with other work of
+ * the same strand, even on an executor with several threads. Each piece
+ * of work is posted to the executor on its own once the previous one has
+ * finished, so a busy strand does not hold on to an executor thread.
+ */
+class Strand : public std::enable_shared_from_this<Strand>
+{
+public:
+  /*!
+   * \brief Create a strand that runs its work on an executor
+   */
+  explicit Strand(Executor executor);
+
+  Strand(const Strand&) = delete;
+  Strand& operator=(const Strand&) = delete;
+  Strand(Strand&&) = delete;
+  Strand& operator=(Strand&&) = delete;
+
+  /*!
+   * \brief Queue work to run after the work queued before it
+   */
+  void execute(std::function<void()> work);
+
+  /*!
+   * \brief Get an Executor that queues work on this strand. It keeps the
+   *        strand alive.
+   */
+  Executor executor();
+
+private:
+  /*!
+   * \brief Run the oldest queued work, then schedule the next
+   */
+  void runNext();
+
+  /*!
+   * \brief Post the next queued work to the executor, or mark the strand
+   *        idle if there is none
+   */
+  void scheduleNext();
+
+  //! Runs the work
+  Executor executor_;
+
+  //! Guards the queue and the running flag
+  std::mutex mutex_;
+
+  //! Work waiting to run
+  std::deque<std::function<void()>> queue_;
+
+  //! Set while work of this strand is posted or running
+  bool running_;
+};
+
+/*!
+ * \brief An awaitable database operation
+ *
+ * `co_await` starts the operation and suspends the awaiting coroutine.
+ * Once the operation has completed, the coroutine is resumed through the
+ * resume executor, or directly on the thread that completed the
+ * operation if there is none. The awaitable works with any coroutine
+ * type; it does not need a particular task or event loop library.
+ *
+ * Example:
+ * \code
+ * auto product = co_await productDAO.coSelectById(id);
+ * \endcode
+ *
+ * If the operation fails with an exception, the exception is rethrown
+ * into the awaiting coroutine.
+ *
+ * \tparam R The result of the operation
+ */
+template <typename R>
+class AsyncResult
+{
+public:
+  /*!
+   * \brief Completes the operation and resumes the awaiting coroutine
+   *
+   * Exactly one of its call operator and fail() must be called, exactly
+   * once, on any thread.
+   */
+  class Completion
+  {
+  public:
+    Completion(AsyncResult& awaitable, std::coroutine_handle<> caller)
+      : pAwaitable_{&awaitable}, caller_{caller}
+    {
+    }
+
+    /*!
+     * \brief Complete the operation with its result
+     */
+    void operator()(R result) const
+    {
+      pAwaitable_->result_.emplace(std::move(result));
+      resume();
+    }
+
+    /*!
+     * \brief Complete the operation with an exception, which await_resume()
+     *        rethrows
+     */
+    void fail(std::exception_ptr error) const
+    {
+      pAwaitable_->error_ = std::move(error);
+      resume();
+    }
+
+  private:
+    void resume() const
+    {
+      // The awaitable is gone once the caller resumes, so nothing here may
+      // be touched after the resumption
+      Executor resumeOn = std::move(pAwaitable_->resumeOn_);
+      if (resumeOn)
+      {
+        resumeOn([caller = caller_] { caller.resume(); });
+      }
+      else
+      {
+        caller_.resume();
+      }
+    }
+
+    //! The awaitable that receives the result
+    AsyncResult* pAwaitable_;
+
+    //! The awaiting coroutine
+    std::coroutine_handle<> caller_;
+  };
+
+  //! Starts the operation. It must complete it exactly once, on any
+  //! thread.
+  using Launch = std::function<void(Completion)>;
+
+  /*!
+   * \brief Create an operation that is started when it is awaited
+   * \param launch Starts the operation
+   * \param resumeOn Resumes the awaiting coroutine. Empty to resume on
+   *        the completing thread.
+   */
+  AsyncResult(Launch launch, Executor resumeOn)
+    : launch_{std::move(launch)},
+      resumeOn_{std::move(resumeOn)},
+      result_{},
+      error_{nullptr}
+  {
+  }
+
+  /*!
+   * \brief Create an operation that has already completed
+   */
+  static AsyncResult ready(R result)
+  {
+    AsyncResult completed{nullptr, nullptr};
+    completed.result_.emplace(std::move(result));
+    return completed;
+  }
+
+  /*!
+   * \brief Create an operation that has already failed
+   */
+  static AsyncResult failed(std::exception_ptr error)
+  {
+    AsyncResult completed{nullptr, nullptr};
+    completed.error_ = std::move(error);
+    return completed;
+  }
+
+  bool await_ready() const noexcept
+  {
+    return result_.has_value() || error_ != nullptr;
+  }
+
+  void await_suspend(std::coroutine_handle<> caller)
+  {
+    // The coroutine, and with it this awaitable, may be resumed and
+    // destroyed before launch() returns, so nothing here may be touched
+    // after the launch
+    Launch launch = std::move(launch_);
+    launch(Completion{*this, caller});
+  }
+
+  R await_resume()
+  {
+    if (error_)
+    {
+      std::rethrow_exception(error_);
+    }
+    return std::move(*result_);
+  }
+
+private:
+  //! Starts the operation
+  Launch launch_;
+
+  //! Resumes the awaiting coroutine
+  Executor resumeOn_;
+
+  //! The result, once the operation has completed
+  std::optional<R> result_;
+
+  //! The exception the operation failed with, if any
+  std::exception_ptr error_;
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_ASYNC_HPP
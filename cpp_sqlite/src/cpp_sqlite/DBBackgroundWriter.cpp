@@ -0,0 +1,130 @@
+#include "cpp_sqlite/src/cpp_sqlite/DBBackgroundWriter.hpp"
+
+#include <algorithm>
+
+namespace cpp_sqlite
+{
+
+BackgroundWriter::BackgroundWriter(std::function<void()> flush,
+                                   std::function<std::size_t()> bufferedRows,
+                                   FlushPolicy policy,
+                                   std::shared_ptr<spdlog::logger> pLogger)
+  : flush_{std::move(flush)},
+    bufferedRows_{std::move(bufferedRows)},
+    policy_{policy},
+    mutex_{},
+    wakeWriter_{},
+    flushCompleted_{},
+    requestedTicket_{0},
+    completedTicket_{0},
+    stopping_{false},
+    finished_{false},
+    pLogger_{pLogger},
+    thread_{&BackgroundWriter::run, this}
+{
+  LOG_SAFE(pLogger_,
+           spdlog::level::debug,
+           "Started background writer (max rows: {}, max delay: {} ms)",
+           policy_.maxBufferedRows,
+           policy_.maxDelay.count());
+}
+
+BackgroundWriter::~BackgroundWriter()
+{
+  stop();
+}
+
+uint64_t BackgroundWriter::requestFlush()
+{
+  uint64_t ticket = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ticket = ++requestedTicket_;
+  }
+  wakeWriter_.notify_one();
+  return ticket;
+}
+
+void BackgroundWriter::waitFor(uint64_t ticket)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  flushCompleted_.wait(
+    lock, [&] { return completedTicket_ >= ticket || finished_; });
+}
+
+void BackgroundWriter::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wakeWriter_.notify_one();
+
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+}
+
+const FlushPolicy& BackgroundWriter::getPolicy() const
+{
+  return policy_;
+}
+
+void BackgroundWriter::run()
+{
+  using Clock = std::chrono::steady_clock;
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto deadline = Clock::now() + policy_.maxDelay;
+
+  while (!stopping_)
+  {
+    wakeWriter_.wait_for(
+      lock,
+      std::min(policy_.pollInterval, policy_.maxDelay),
+      [&] { return stopping_ || requestedTicket_ > completedTicket_; });
+
+    if (stopping_)
+    {
+      break;
+    }
+
+    bool due = requestedTicket_ > completedTicket_ || Clock::now() >= deadline;
+
+    lock.unlock();
+    due = due || bufferedRows_() >= policy_.maxBufferedRows;
+    lock.lock();
+
+    if (!due)
+    {
+      continue;
+    }
+
+    // Every ticket handed out so far is covered by this flush, because the
+    // buffers are swapped after the tickets were requested.
+    uint64_t ticket = requestedTicket_;
+
+    lock.unlock();
+    flush_();
+    lock.lock();
+
+    completedTicket_ = std::max(completedTicket_, ticket);
+    deadline = Clock::now() + policy_.maxDelay;
+    flushCompleted_.notify_all();
+  }
+
+  // Final flush so that nothing buffered before shutdown is lost
+  uint64_t ticket = requestedTicket_;
+  lock.unlock();
+  flush_();
+  lock.lock();
+
+  completedTicket_ = std::max(completedTicket_, ticket);
+  finished_ = true;
+  flushCompleted_.notify_all();
+
+  LOG_SAFE(pLogger_, spdlog::level::debug, "Stopped background writer");
+}
+
+}  // namespace cpp_sqlite
@@ -0,0 +1,144 @@
+#ifndef DB_BACKGROUND_WRITER_HPP
+#define DB_BACKGROUND_WRITER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "cpp_sqlite/src/utils/Logger.hpp"
+
+namespace cpp_sqlite
+{
+
+/*!
+ * \brief Controls when the background writer flushes the DAO buffers
+ *
+ * A flush happens as soon as either limit is reached: the number of rows
+ * waiting in the buffers reaches maxBufferedRows, or maxDelay has passed
+ * since the previous flush.
+ */
+struct FlushPolicy
+{
+  //! Flush once this many rows are buffered across all DAOs
+  std::size_t maxBufferedRows{4096};
+
+  //! Flush at least this often
+  std::chrono::milliseconds maxDelay{100};
+
+  //! How often the writer checks the number of buffered rows
+  std::chrono::milliseconds pollInterval{5};
+};
+
+/*!
+ * \brief A thread that periodically flushes buffered rows to disk
+ *
+ * The writer does not know about DAOs itself; it is given a function that
+ * flushes every buffer and a function that reports how many rows are
+ * waiting. Producers only ever touch the DAO write buffers, so they never
+ * wait on disk I/O.
+ *
+ * Callers can request an immediate flush with requestFlush() and block
+ * until a requested flush has been committed with waitFor().
+ */
+class BackgroundWriter
+{
+public:
+  /*!
+   * \brief Start the writer thread
+   * \param flush Flushes every buffer. Only ever called from the writer
+   *        thread.
+   * \param bufferedRows Returns the number of rows currently buffered
+   * \param policy The flush policy
+   * \param pLogger Optional logger
+   */
+  BackgroundWriter(std::function<void()> flush,
+                   std::function<std::size_t()> bufferedRows,
+                   FlushPolicy policy,
+                   std::shared_ptr<spdlog::logger> pLogger = nullptr);
+
+  /*!
+   * \brief Stop the writer, flushing any remaining rows first
+   */
+  ~BackgroundWriter();
+
+  BackgroundWriter(const BackgroundWriter&) = delete;
+  BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+  BackgroundWriter(BackgroundWriter&&) = delete;
+  BackgroundWriter& operator=(BackgroundWriter&&) = delete;
+
+  /*!
+   * \brief Ask the writer to flush as soon as possible
+   * \return A ticket that can be passed to waitFor()
+   */
+  uint64_t requestFlush();
+
+  /*!
+   * \brief Block until the flush identified by the ticket has completed
+   *
+   * Every row that was buffered before requestFlush() returned the ticket
+   * is committed once this returns. Returns immediately if the writer has
+   * already stopped.
+   */
+  void waitFor(uint64_t ticket);
+
+  /*!
+   * \brief Perform a final flush and join the writer thread
+   */
+  void stop();
+
+  /*!
+   * \brief Get the flush policy of this writer
+   */
+  const FlushPolicy& getPolicy() const;
+
+private:
+  /*!
+   * \brief The writer thread main loop
+   */
+  void run();
+
+  //! Flushes all buffers
+  std::function<void()> flush_;
+
+  //! Reports the number of buffered rows
+  std::function<std::size_t()> bufferedRows_;
+
+  //! The flush policy
+  FlushPolicy policy_;
+
+  //! Guards the tickets and the stop flag
+  std::mutex mutex_;
+
+  //! Wakes the writer thread
+  std::condition_variable wakeWriter_;
+
+  //! Wakes threads waiting for a flush to complete
+  std::condition_variable flushCompleted_;
+
+  //! The most recently handed out flush ticket
+  uint64_t requestedTicket_;
+
+  //! The highest ticket whose flush has completed
+  uint64_t completedTicket_;
+
+  //! Set when the writer should exit
+  bool stopping_;
+
+  //! Set once the writer thread has performed its final flush
+  bool finished_;
+
+  //! The local logger
+  std::shared_ptr<spdlog::logger> pLogger_;
+
+  //! The writer thread (declared last so it starts after the state above)
+  std::thread thread_;
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_BACKGROUND_WRITER_HPP
@@ -0,0 +1,369 @@
+#ifndef DB_CURSOR_HPP
+#define DB_CURSOR_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "sqlite3.h"
+
+#include "cpp_sqlite/src/cpp_sqlite/DBAsync.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBDatabase.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBReadPool.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBTraits.hpp"
+#include "cpp_sqlite/src/utils/Logger.hpp"
+
+namespace cpp_sqlite
+{
+
+/*!
+ * \brief A single-pass range over the rows of a SELECT statement
+ *
+ * Rows are decoded as the cursor is advanced instead of being collected
+ * into a std::vector first, so memory use does not grow with the size of
+ * the table. Types without repeated fields are decoded one row at a time.
+ * For types with repeated fields a page of rows is decoded at once, so
+ * that their children can be loaded with one batched lookup per page.
+ *
+ * The cursor owns its statement. The statement keeps a read transaction
+ * open until the cursor is exhausted or destroyed, so stopping early is
+ * just a matter of leaving the loop.
+ *
+ * Example:
+ * \code
+ * for (const auto& product : productDAO.selectAllCursor())
+ * {
+ *   if (product.price > 100.0f)
+ *   {
+ *     break;
+ *   }
+ * }
+ * \endcode
+ *
+ * \tparam T The transfer object decoded from each row
+ */
+template <ValidTransferObject T>
+class Cursor
+{
+public:
+  /*!
+   * \brief Input iterator over the rows of a cursor
+   *
+   * All iterators of a cursor share its position. The referenced row is
+   * only valid until the iterator is incremented.
+   */
+  class iterator
+  {
+  public:
+    using iterator_concept = std::input_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+
+    explicit iterator(Cursor* cursor) : cursor_{cursor}
+    {
+    }
+
+    T& operator*() const
+    {
+      return cursor_->current();
+    }
+
+    T* operator->() const
+    {
+      return &cursor_->current();
+    }
+
+    iterator& operator++()
+    {
+      cursor_->advance();
+      return *this;
+    }
+
+    void operator++(int)
+    {
+      ++*this;
+    }
+
+    friend bool operator==(const iterator& it, std::default_sentinel_t)
+    {
+      return it.atEnd();
+    }
+
+  private:
+    /*!
+     * \brief Check whether the cursor has no more rows
+     */
+    bool atEnd() const
+    {
+      return cursor_ == nullptr || cursor_->isExhausted();
+    }
+
+    //! The cursor the iterator reads from
+    Cursor* cursor_{nullptr};
+  };
+
+  /*!
+   * \brief Create a cursor over a prepared SELECT statement
+   * \param database The database used to decode rows
+   * \param stmt The statement to step. A null statement yields no rows.
+   * \param pageSize The number of rows decoded at once
+   * \param pLogger Optional logger for reporting failures
+   */
+  Cursor(Database& database,
+         PreparedSQLStmt stmt,
+         std::size_t pageSize,
+         std::shared_ptr<spdlog::logger> pLogger = nullptr)
+    : db_{database},
+      stmt_{std::move(stmt)},
+      page_{},
+      position_{0},
+      pageSize_{pageSize == 0 ? 1 : pageSize},
+      started_{false},
+      stepsDone_{stmt_ == nullptr},
+      pLogger_{pLogger}
+  {
+  }
+
+  Cursor(const Cursor&) = delete;
+  Cursor& operator=(const Cursor&) = delete;
+  Cursor(Cursor&&) = default;
+
+  /*!
+   * \brief Get an iterator positioned on the first row not yet read
+   */
+  iterator begin()
+  {
+    if (!started_)
+    {
+      started_ = true;
+      fetchPage();
+    }
+    return iterator{this};
+  }
+
+  std::default_sentinel_t end() const
+  {
+    return std::default_sentinel;
+  }
+
+private:
+  /*!
+   * \brief The row the cursor is positioned on
+   */
+  T& current()
+  {
+    return page_[position_];
+  }
+
+  /*!
+   * \brief Move to the next row, decoding a new page when needed
+   */
+  void advance()
+  {
+    if (++position_ >= page_.size())
+    {
+      fetchPage();
+    }
+  }
+
+  /*!
+   * \brief Check whether every row has been read
+   */
+  bool isExhausted() const
+  {
+    return position_ >= page_.size();
+  }
+
+  /*!
+   * \brief Decode up to pageSize_ rows into the page buffer
+   */
+  void fetchPage()
+  {
+    page_.clear();
+    position_ = 0;
+
+    while (!stepsDone_ && page_.size() < pageSize_)
+    {
+      int result = sqlite3_step(stmt_.get());
+      if (result != SQLITE_ROW)
+      {
+        if (result != SQLITE_DONE)
+        {
+          LOG_SAFE(pLogger_,
+                   spdlog::level::err,
+                   "Cursor step failed with code: {}",
+                   result);
+        }
+
+        // Release the read transaction as soon as the rows are exhausted
+        sqlite3_reset(stmt_.get());
+        stepsDone_ = true;
+        break;
+      }
+
+      T obj;
+      int columnIndex = 0;
+      db_.readColumns(stmt_.get(), obj, columnIndex);
+      page_.push_back(std::move(obj));
+    }
+
+    db_.loadRepeatedFields<T>(std::span<T>{page_});
+  }
+
+  //! The database used to decode rows
+  Database& db_;
+
+  //! The SELECT statement owned by this cursor
+  PreparedSQLStmt stmt_;
+
+  //! The decoded rows of the current page (capacity is reused)
+  std::vector<T> page_;
+
+  //! The position of the current row in page_
+  std::size_t position_;
+
+  //! The maximum number of rows decoded at once
+  std::size_t pageSize_;
+
+  //! Whether the first page has been fetched
+  bool started_;
+
+  //! Whether the statement has returned its last row
+  bool stepsDone_;
+
+  //! The local logger
+  std::shared_ptr<spdlog::logger> pLogger_;
+};
+
+/*!
+ * \brief An asynchronous cursor over all rows of a table
+ *
+ * Each next() yields one row. Rows are fetched a page at a time on the
+ * database's async executor, so a coroutine only suspends once per page.
+ * The first fetch leases a pooled reader if a read pool is open.
+ *
+ * Example:
+ * \code
+ * auto cursor = productDAO.coSelectAll();
+ * while (auto product = co_await cursor.next())
+ * {
+ *   total += product->price;
+ * }
+ * \endcode
+ *
+ * The cursor must not be moved or destroyed while a next() is pending.
+ *
+ * \tparam T The transfer object read by the cursor
+ */
+template <ValidTransferObject T>
+class AsyncCursor
+{
+public:
+  //! The number of rows fetched per suspension
+  static constexpr std::size_t kPageSize = 256;
+
+  /*!
+   * \brief Create a cursor over all rows of T
+   * \param database The database to read from
+   */
+  explicit AsyncCursor(Database& database)
+    : db_{database},
+      lease_{},
+      pCursor_{nullptr},
+      it_{},
+      page_{},
+      position_{0},
+      exhausted_{false}
+  {
+  }
+
+  AsyncCursor(const AsyncCursor&) = delete;
+  AsyncCursor& operator=(const AsyncCursor&) = delete;
+  AsyncCursor(AsyncCursor&&) = default;
+
+  /*!
+   * \brief Get the next row
+   * \return An awaitable that yields the row, or an empty optional once
+   *         every row has been read
+   */
+  AsyncResult<std::optional<T>> next()
+  {
+    if (position_ < page_.size())
+    {
+      return AsyncResult<std::optional<T>>::ready(
+        std::move(page_[position_++]));
+    }
+
+    if (exhausted_)
+    {
+      return AsyncResult<std::optional<T>>::ready(std::nullopt);
+    }
+
+    return db_.runAsync<std::optional<T>>(
+      [this]() -> std::optional<T>
+      {
+        fetchPage();
+        if (position_ < page_.size())
+        {
+          return std::move(page_[position_++]);
+        }
+        return std::nullopt;
+      });
+  }
+
+private:
+  /*!
+   * \brief Read the next page of rows, opening the cursor on first use
+   */
+  void fetchPage()
+  {
+    if (!pCursor_)
+    {
+      lease_ = db_.leaseReader();
+      Database& source = lease_ ? *lease_ : db_;
+      pCursor_ =
+        std::make_unique<Cursor<T>>(source.getDAO<T>().selectAllCursor());
+      it_ = pCursor_->begin();
+    }
+
+    page_.clear();
+    position_ = 0;
+    while (page_.size() < kPageSize && it_ != std::default_sentinel)
+    {
+      page_.push_back(std::move(*it_));
+      ++it_;
+    }
+    exhausted_ = it_ == std::default_sentinel;
+  }
+
+  //! The database the rows are read from
+  Database& db_;
+
+  //! The pooled reader the cursor's statement runs on, if any
+  ReadLease lease_;
+
+  //! The synchronous cursor, opened by the first fetch
+  std::unique_ptr<Cursor<T>> pCursor_;
+
+  //! The position of the synchronous cursor
+  typename Cursor<T>::iterator it_;
+
+  //! The current page of rows
+  std::vector<T> page_;
+
+  //! The next row of page_ to hand out
+  std::size_t position_;
+
+  //! Whether the synchronous cursor has no more rows
+  bool exhausted_;
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_CURSOR_HPP
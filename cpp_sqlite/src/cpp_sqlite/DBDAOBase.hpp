@@ -1,8 +1,38 @@
 #ifndef DB_DAO_BASE_HPP
 #define DB_DAO_BASE_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <vector>
+
+namespace cpp_sqlite
+{
+
+class MetricsRegistry;
+
+/*!
+ * \brief The outcome of flushing a DAO's write buffer
+ */
+struct FlushResult
+{
+  //! The number of rows that were committed to the database
+  std::size_t succeeded{0};
+
+  //! The identifiers of the rows that could not be inserted
+  std::vector<uint32_t> failedIds;
+
+  //! The number of transactions (or savepoints) used for the flush
+  std::size_t transactions{0};
+
+  /*!
+   * \brief Check whether every buffered row was committed
+   */
+  bool ok() const
+  {
+    return failedIds.empty();
+  }
+};
 
 /*!
  * Abstract base class for all Data Access Objects
@@ -33,13 +63,45 @@ public:
 
   /*!
    * \brief Perform insert operation with buffered data
+   * \return The number of committed rows and the rows that failed
    */
-  virtual void insert() = 0;
+  virtual FlushResult insert() = 0;
 
   /*!
    * \brief Clear the internal data buffer
    */
   virtual void clearBuffer() = 0;
+
+  /*!
+   * \brief Get the number of rows waiting in the write buffer
+   */
+  virtual std::size_t bufferedCount() const = 0;
+
+  /*!
+   * \brief Drop a row from the select cache after it was written
+   * \param id The ID of the written row
+   * \param contentChanged True if an existing row was updated or deleted,
+   *        in which case the caches of tables that embed this table's
+   *        rows are cleared as well
+   */
+  virtual void invalidateCachedRow(uint32_t id, bool contentChanged) = 0;
+
+  /*!
+   * \brief Drop every row from the select cache, and from the caches of
+   *        tables that embed this table's rows
+   */
+  virtual void clearCache() = 0;
+
+  /*!
+   * \brief Record the metrics of this DAO's statements in a registry
+   * \param pRegistry The registry, or nullptr to stop recording
+   */
+  virtual void attachMetrics(MetricsRegistry* pRegistry) = 0;
 };
 
+}  // namespace cpp_sqlite
+
+// DAOBase used to live in the global namespace; keep that name working
+using cpp_sqlite::DAOBase;
+
 #endif  // DB_DAO_BASE_HPP
\ No newline at end of file
@@ -1,11 +1,18 @@
 #ifndef DATA_ACCESS_OBJECT_HPP
 #define DATA_ACCESS_OBJECT_HPP
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <future>
+#include <iterator>
 #include <memory>
 #include <mutex>
 #include <optional>
-#include <sstream>
+#include <span>
 #include <string>
+#include <typeindex>
 #include <typeinfo>
 #include <unordered_map>
 #include <vector>
@@ -13,14 +20,19 @@
 #include <boost/describe.hpp>
 #include <boost/describe/class.hpp>
 #include <boost/mp11.hpp>
-#include <boost/type_index.hpp>
 #include "sqlite3.h"
 
+#include "cpp_sqlite/src/cpp_sqlite/DBCursor.hpp"
 #include "cpp_sqlite/src/cpp_sqlite/DBDAOBase.hpp"
 #include "cpp_sqlite/src/cpp_sqlite/DBDatabase.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBMetrics.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBRingBuffer.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBRowView.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBSelectCache.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBStaticSQL.hpp"
 #include "cpp_sqlite/src/cpp_sqlite/DBTraits.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBTransaction.hpp"
 #include "cpp_sqlite/src/utils/Logger.hpp"
-#include "cpp_sqlite/src/utils/StringUtils.hpp"
 
 namespace cpp_sqlite
 {
@@ -31,31 +43,193 @@ template <ValidTransferObject T>
 class DataAccessObject : public DAOBase
 {
 public:
+  //! Default upper bound on the rows bound to one multi-row INSERT
+  static constexpr std::size_t kDefaultMaxRowsPerInsert = 256;
+
+  //! Default upper bound on the parent IDs bound to one junction SELECT
+  static constexpr std::size_t kDefaultMaxIdsPerLookup = 256;
+
+  //! Default number of slots of a lock-free write buffer
+  static constexpr std::size_t kDefaultRingCapacity = 8192;
+
+  //! Default maximum number of rows kept in the select cache
+  static constexpr std::size_t kDefaultCacheEntries = 4096;
+
+  //! The name of the table accessed by this object (see sqlTableName)
+  static constexpr std::string_view tableName = sqlTableName<T>;
+
   /*!
    * Construct a data access object for this
    * database
    */
   DataAccessObject(Database& database,
                    std::shared_ptr<spdlog::logger> pLogger = nullptr)
-    : tableName_{stripNamespace(boost::typeindex::type_id<T>().pretty_name())},
-      insertStmt_{nullptr, sqlite3_finalize},
+    : insertStmt_{nullptr, sqlite3_finalize},
+      multiRowInsertStmts_{},
+      multiRowScratch_{},
       selectAllStmt_{nullptr, sqlite3_finalize},
       selectByIdStmt_{nullptr, sqlite3_finalize},
+      selectByIdsStmts_{},
+      junctionStmts_{},
+      metrics_{},
       writeBuffer_{},
       flushBuffer_{},
+      selectCache_{CachePolicy::LRU, kDefaultCacheEntries, 0},
+      cacheMutex_{},
+      cacheGeneration_{0},
+      cacheWriteThrough_{true},
+      dependentCaches_{},
+      bufferedCount_{0},
+      highWaterMark_{0},
+      reservedCapacity_{0},
+      pRingBuffer_{nullptr},
+      bufferUsed_{false},
       idCounter_{0},
+      maxRowsPerTransaction_{0},
+      maxRowsPerInsert_{1},
+      maxIdsPerLookup_{1},
       isInitialized_{true},
       db_{database},
       pLogger_{pLogger}
   {
     isInitialized_ = executeCreateStmt();
+    isInitialized_ &= registerNestedDAOs();
     isInitialized_ &= prepareInsertStatement();
     isInitialized_ &= prepareSelectStatements();
+    isInitialized_ &= prepareJunctionStatements();
   }
 
   std::string getTableName() const override
   {
-    return tableName_;
+    return std::string{tableName};
+  }
+
+  /*!
+   * \brief Get the cached INSERT statement for the junction table that
+   *        links this table to the repeated field type Child
+   * \return The statement, or nullptr if T has no such repeated field
+   */
+  template <ValidTransferObject Child>
+  PreparedSQLStmt* getJunctionInsertStatement()
+  {
+    auto it = junctionStmts_.find(std::type_index(typeid(Child)));
+    return it == junctionStmts_.end() ? nullptr : &it->second.insertStmt;
+  }
+
+  /*!
+   * \brief Get (or lazily prepare) the SELECT statement that loads the
+   *        Child rows of several parent rows at once
+   *
+   * The statement joins the junction table to the child table and binds
+   * one parent ID per host parameter. Each result row holds the parent ID
+   * followed by the child's columns as laid out by
+   * detail::appendSelectSource().
+   *
+   * \param idCount The number of parent IDs bound to the statement
+   * \return The statement, or nullptr if T has no such repeated field or
+   *         the statement could not be prepared
+   */
+  template <ValidTransferObject Child>
+  PreparedSQLStmt* getJunctionSelectStatement(std::size_t idCount)
+  {
+    auto it = junctionStmts_.find(std::type_index(typeid(Child)));
+    if (it == junctionStmts_.end())
+    {
+      return nullptr;
+    }
+
+    auto& selectStmts = it->second.selectStmts;
+    auto stmtIt = selectStmts.find(idCount);
+    if (stmtIt != selectStmts.end())
+    {
+      return &stmtIt->second;
+    }
+
+    std::string sql{it->second.selectPrefix};
+    for (std::size_t i = 0; i < idCount; ++i)
+    {
+      sql += i == 0 ? "?" : ", ?";
+    }
+    sql += it->second.selectSuffix;
+
+    PreparedSQLStmt stmt{nullptr, sqlite3_finalize};
+    if (!prepareCachedStatement(
+          sql, stmt, "junction select", it->second.tableName))
+    {
+      return nullptr;
+    }
+
+    auto result = selectStmts.emplace(idCount, std::move(stmt));
+    return &result.first->second;
+  }
+
+  /*!
+   * \brief Get the metrics of a junction table statement
+   * \param kind StatementKind::JunctionInsert or
+   *        StatementKind::JunctionSelect
+   * \return The metrics, or nullptr if metrics are disabled or T has no
+   *         such repeated field
+   */
+  template <ValidTransferObject Child>
+  StatementMetrics* getJunctionMetrics(StatementKind kind) const
+  {
+#ifdef CPP_SQLITE_DISABLE_METRICS
+    (void)kind;
+    return nullptr;
+#else
+    auto it = junctionStmts_.find(std::type_index(typeid(Child)));
+    if (it == junctionStmts_.end())
+    {
+      return nullptr;
+    }
+
+    const auto& metrics = kind == StatementKind::JunctionInsert
+                            ? it->second.insertMetrics
+                            : it->second.selectMetrics;
+    return metrics.load(std::memory_order_acquire);
+#endif
+  }
+
+  /*!
+   * \brief Get the largest number of parent IDs bound to one junction
+   *        SELECT statement
+   */
+  std::size_t getMaxIdsPerLookup() const
+  {
+    return maxIdsPerLookup_;
+  }
+
+  /*!
+   * \brief Create an index on the child column of every junction table of
+   *        this table
+   *
+   * Junction tables are keyed by (parent_id, child_id), which serves
+   * lookups by parent. The reverse index serves lookups of the parents of
+   * a child, at the cost of slower junction inserts.
+   *
+   * \return True if every index was created (or already existed)
+   */
+  bool createJunctionReverseIndexes()
+  {
+    bool success = true;
+
+    boost::mp11::mp_for_each<boost::describe::describe_members<
+      T,
+      boost::describe::mod_inherited | boost::describe::mod_public>>(
+      [&](auto D)
+      {
+        using memberType = std::remove_cv_t<
+          std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+
+        if constexpr (IsRepeatedFieldTransferObject<memberType>)
+        {
+          using junctionSQL =
+            JunctionSQL<T, RepeatedFieldOfType<memberType>>;
+          success &= executeSQL(junctionSQL::createReverseIndex.c_str());
+        }
+      });
+
+    return success;
   }
 
   /*!
@@ -74,60 +248,157 @@ public:
       return false;
     }
 
-    if (data.id == std::numeric_limits<uint32_t>::max())
-    {
-      data.id = incrementIdCounter();
-    }
-    // If the ID has been manually specified by the user without using
-    // the class-given `incrementIdCounter()` function, we want to log
-    // an error and fail to execute the insert.
-    else if (data.id <= idCounter_)
+    if (!assignId(data))
     {
-      LOG_SAFE(pLogger_,
-               spdlog::level::err,
-               "The identifier for this transfer object has been manually set "
-               "outside of the context of the DataAccessObject");
       return false;
     }
-    else
+
+    if (!db_.insert(
+          insertStmt_, data, statementMetrics(StatementKind::Insert)))
     {
-      // Manual ID is valid and higher than counter - update counter to prevent
-      // conflicts
-      LOG_SAFE(pLogger_,
-               spdlog::level::warn,
-               "Manual ID {} is higher than current counter {}. Updating "
-               "counter to prevent future conflicts.",
-               data.id,
-               idCounter_);
-      idCounter_ = data.id;
+      return false;
     }
 
+    writeThrough(data);
+    return true;
+  }
+
+  /*!
+   * \brief Insert a row on the database's write actor
+   *
+   * Without a write actor the row is inserted immediately on the calling
+   * thread. The row is copied into the command, so its assigned ID is not
+   * reported back.
+   *
+   * \param data The row to insert
+   * \return A future that becomes true once the row is committed
+   */
+  std::future<bool> insertAsync(T data)
+  {
+    return db_.submitWrite([this, row = std::move(data)]() mutable
+                           { return insert(row); });
+  }
+
+  /*!
+   * \brief Insert a row from a coroutine without blocking it
+   *
+   * Runs on the write actor if the database has one, otherwise on its
+   * async executor (see Database::setAsyncExecutor()).
+   *
+   * \param data The row to insert
+   * \return An awaitable that yields true once the row is committed
+   */
+  AsyncResult<bool> coInsert(T data)
+  {
+    return db_.runAsyncWrite([this, row = std::move(data)]() mutable
+                             { return insert(row); });
+  }
 
-    return db_.insert(insertStmt_, data);
+  /*!
+   * \brief Flush the write buffer from a coroutine without blocking it
+   * \return An awaitable that yields true if every buffered row was
+   *         committed
+   */
+  AsyncResult<bool> coFlush()
+  {
+    return db_.runAsyncWrite([this] { return insert().ok(); });
   }
 
   /*!
    * \brief Perform an insert with the buffer data
    * Thread-safe: Swaps buffers under lock, then processes without lock
+   *
+   * The buffered rows are written inside a transaction so that the whole
+   * flush pays for a single journal sync. If a transaction is already open
+   * on the connection, a SAVEPOINT is used instead. When a maximum number
+   * of rows per transaction is configured, the flush is split into several
+   * consecutive transactions.
+   *
+   * \return The number of committed rows and the ids of the failed rows
    */
-  void insert() override
+  FlushResult insert() override
   {
     // Swap the write and flush buffers under a lock
     {
       std::lock_guard<std::mutex> lock(bufferMutex_);
       std::swap(writeBuffer_, flushBuffer_);
+      bufferedCount_.store(0, std::memory_order_relaxed);
+
+      // Only allocates the first time a buffer half is swapped in after
+      // reserveBuffer(); afterwards both halves keep their capacity.
+      writeBuffer_.reserve(reservedCapacity_);
+    }
+
+    // This thread is the single consumer of the lock-free buffer
+    if (pRingBuffer_)
+    {
+      pRingBuffer_->drain(flushBuffer_);
     }
 
     // Now process flushBuffer_ without holding the lock
     // Writers can continue adding to writeBuffer_ in parallel
-    bool success = true;
-    for (auto& item : flushBuffer_)
+    FlushResult flushResult{};
+
+    const std::size_t batchSize = maxRowsPerTransaction_ == 0
+                                    ? flushBuffer_.size()
+                                    : maxRowsPerTransaction_;
+
+    std::span<T> remaining{flushBuffer_};
+    while (!remaining.empty())
     {
-      success &= insert(item);
+      std::size_t count = std::min(batchSize, remaining.size());
+      flushBatch(remaining.first(count), flushResult);
+      remaining = remaining.subspan(count);
     }
 
-    // Clear the flush buffer after processing
+    // Clear the flush buffer after processing. Its capacity is kept so
+    // that it can be swapped back in as the write buffer.
     flushBuffer_.clear();
+
+    return flushResult;
+  }
+
+  /*!
+   * \brief Set the maximum number of rows written per transaction when
+   *        flushing the buffer
+   * \param maxRows The row limit. Zero writes each flush in one transaction.
+   */
+  void setMaxRowsPerTransaction(std::size_t maxRows)
+  {
+    maxRowsPerTransaction_ = maxRows;
+  }
+
+  /*!
+   * \brief Get the maximum number of rows written per transaction
+   */
+  std::size_t getMaxRowsPerTransaction() const
+  {
+    return maxRowsPerTransaction_;
+  }
+
+  /*!
+   * \brief Set the maximum number of rows bound to one multi-row INSERT
+   *        statement when flushing the buffer
+   *
+   * Only transfer objects without nested objects or repeated fields are
+   * written with multi-row statements. The value is clamped to what
+   * SQLITE_MAX_VARIABLE_NUMBER allows. A value of 1 disables multi-row
+   * inserts.
+   *
+   * \param maxRows The row limit per statement
+   */
+  void setMaxRowsPerInsert(std::size_t maxRows)
+  {
+    maxRowsPerInsert_ =
+      std::clamp<std::size_t>(maxRows, 1, maxRowsForVariableLimit());
+  }
+
+  /*!
+   * \brief Get the maximum number of rows bound to one INSERT statement
+   */
+  std::size_t getMaxRowsPerInsert() const
+  {
+    return maxRowsPerInsert_;
   }
 
   /*!
@@ -138,24 +409,188 @@ public:
     std::lock_guard<std::mutex> lock(bufferMutex_);
     writeBuffer_.clear();
     flushBuffer_.clear();
+    bufferedCount_.store(0, std::memory_order_relaxed);
+
+    if (pRingBuffer_)
+    {
+      pRingBuffer_->drain(flushBuffer_);
+      flushBuffer_.clear();
+    }
+  }
+
+  /*!
+   * \brief Get the number of rows waiting in the write buffer
+   *
+   * Lock-free, so it can be polled by a background writer without
+   * contending with producers.
+   */
+  std::size_t bufferedCount() const override
+  {
+    std::size_t count = bufferedCount_.load(std::memory_order_relaxed);
+    if (pRingBuffer_)
+    {
+      count += pRingBuffer_->size();
+    }
+    return count;
   }
 
   /*!
    * \brief Add object to buffer for insertion (thread-safe)
    * This can be called from any thread
+   * \return False if the row was dropped because a lock-free buffer with
+   *         the Drop policy was full
+   */
+  bool addToBuffer(const T& obj)
+  {
+    return pushToBuffer(obj);
+  }
+
+  /*!
+   * \brief Move an object into the buffer for insertion (thread-safe)
+   *
+   * Avoids copying strings, blobs and repeated field vectors.
+   *
+   * \return False if the row was dropped because a lock-free buffer with
+   *         the Drop policy was full
+   */
+  bool addToBuffer(T&& obj)
+  {
+    return pushToBuffer(std::move(obj));
+  }
+
+  /*!
+   * \brief Construct an object directly in the buffer (thread-safe)
+   *
+   * With the mutex backend the object is constructed in place in the
+   * write buffer. The lock-free backend constructs it and moves it into
+   * a ring slot.
+   *
+   * \param args Arguments forwarded to the constructor of T
+   * \return False if the row was dropped because a lock-free buffer with
+   *         the Drop policy was full
+   */
+  template <typename... Args>
+  bool emplaceToBuffer(Args&&... args)
+  {
+    markBufferUsed();
+    if (pRingBuffer_)
+    {
+      return pRingBuffer_->push(T(std::forward<Args>(args)...));
+    }
+
+    std::lock_guard<std::mutex> lock(bufferMutex_);
+    writeBuffer_.emplace_back(std::forward<Args>(args)...);
+    recordBufferedCount();
+    return true;
+  }
+
+  /*!
+   * \brief Preallocate room for a number of buffered rows
+   *
+   * The capacity is kept for both halves of the double buffer, so once
+   * the buffers have been reserved, buffering up to this many rows per
+   * flush performs no heap allocation for fixed-size transfer objects.
+   *
+   * \param capacity The number of rows to reserve room for
    */
-  void addToBuffer(const T& obj)
+  void reserveBuffer(std::size_t capacity)
   {
     std::lock_guard<std::mutex> lock(bufferMutex_);
-    writeBuffer_.push_back(obj);
+    writeBuffer_.reserve(capacity);
+    reservedCapacity_ = std::max(reservedCapacity_, capacity);
+  }
+
+  /*!
+   * \brief Get the number of rows the mutex-guarded write buffer holds
+   *        before it has to grow
+   */
+  std::size_t bufferCapacity()
+  {
+    std::lock_guard<std::mutex> lock(bufferMutex_);
+    return writeBuffer_.capacity();
+  }
+
+  /*!
+   * \brief Select the container backing the write buffer
+   *
+   * The lock-free backend is a bounded multi-producer/single-consumer ring
+   * buffer, so producers never take a lock. Only one thread may flush the
+   * buffer at a time.
+   *
+   * Producers and the background writer use the backend without holding a
+   * lock, so it can only be selected before the first row is buffered and
+   * before a background writer is started.
+   *
+   * \param backend The buffer backend
+   * \param capacity The number of slots of a lock-free buffer
+   * \param fullPolicy What a lock-free buffer does when it is full
+   * \return False if rows have already been buffered or a background
+   *         writer is running, in which case the backend is unchanged
+   */
+  bool setBufferBackend(BufferBackend backend,
+                        std::size_t capacity = kDefaultRingCapacity,
+                        BufferFullPolicy fullPolicy = BufferFullPolicy::Block)
+  {
+    std::lock_guard<std::mutex> lock(bufferMutex_);
+
+    if (bufferUsed_.load(std::memory_order_acquire) ||
+        db_.hasBackgroundWriter())
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "Cannot change the buffer backend of {} once rows have been "
+               "buffered or a background writer is running",
+               tableName);
+      return false;
+    }
+
+    pRingBuffer_.reset();
+    if (backend == BufferBackend::LockFree)
+    {
+      pRingBuffer_ = std::make_unique<MPSCRingBuffer<T>>(capacity, fullPolicy);
+    }
+
+    return true;
+  }
+
+  /*!
+   * \brief Get the backend currently used for the write buffer
+   */
+  BufferBackend getBufferBackend() const
+  {
+    return pRingBuffer_ ? BufferBackend::LockFree : BufferBackend::Mutex;
+  }
+
+  /*!
+   * \brief Get the drop, overflow and high-water counters of the write
+   *        buffer
+   */
+  BufferStats bufferStats() const
+  {
+    if (pRingBuffer_)
+    {
+      return pRingBuffer_->stats();
+    }
+
+    BufferStats stats{};
+    stats.highWaterMark = highWaterMark_.load(std::memory_order_relaxed);
+    return stats;
   }
 
   /*!
    * \brief Select all records from the table
+   *
+   * Runs on a pooled read connection if the database has opened one.
+   *
    * \return Vector of all objects in the table
    */
   std::vector<T> selectAll()
   {
+    if (auto reader = db_.leaseReader())
+    {
+      return reader->getDAO<T>().selectAll();
+    }
+
     if (!selectAllStmt_)
     {
       LOG_SAFE(
@@ -163,275 +598,919 @@ public:
       return {};
     }
 
-    return db_.select<T>(selectAllStmt_);
+    return db_.select<T>(selectAllStmt_,
+                         statementMetrics(StatementKind::SelectAll));
+  }
+
+  /*!
+   * \brief Stream all records of the table
+   *
+   * Unlike selectAll(), rows are decoded as the returned cursor is
+   * iterated, so memory use stays constant however large the table is.
+   * The cursor prepares its own statement and may outlive other calls on
+   * this DAO, but not the DAO itself.
+   *
+   * \return A single-pass range over all objects in the table
+   */
+  Cursor<T> selectAllCursor()
+  {
+    // Pages only need to hold more than one row when children are loaded
+    // in batches
+    const std::size_t pageSize = hasRepeatedFields<T>() ? maxIdsPerLookup_ : 1;
+    return Cursor<T>{db_, prepareCursorStatement(), pageSize, pLogger_};
+  }
+
+  /*!
+   * \brief Stream zero-copy views of all records of the table
+   *
+   * Nothing is decoded into T: members are read from the current row with
+   * RowView::get(), with TEXT and BLOB columns returned as views into
+   * SQLite's buffers. Repeated fields are not loaded. Use this for scans
+   * that only read a few members, or that pass large BLOBs on without
+   * keeping them.
+   *
+   * \return A single-pass range of row views over the table
+   */
+  RowViewCursor<T> selectAllViews()
+  {
+    return RowViewCursor<T>{prepareCursorStatement(), pLogger_};
+  }
+
+  /*!
+   * \brief Select a single record by ID from a coroutine without blocking
+   *        it
+   * \param id The ID of the record to retrieve
+   * \return An awaitable that yields the object, or an empty optional if
+   *         it was not found
+   */
+  AsyncResult<std::optional<T>> coSelectById(uint32_t id)
+  {
+    return db_.runAsync<std::optional<T>>([this, id]
+                                          { return selectById(id); });
+  }
+
+  /*!
+   * \brief Stream all records of the table from a coroutine without
+   *        blocking it
+   * \return An async generator over all objects in the table
+   */
+  AsyncCursor<T> coSelectAll()
+  {
+    return AsyncCursor<T>{db_};
+  }
+
+  /*!
+   * \brief Select a single record by ID through the select cache
+   *
+   * The returned pointer pins the row, so it stays valid after the entry
+   * is evicted from the cache.
+   *
+   * \param id The ID of the record to retrieve
+   * \return The cached object, or nullptr if it was not found
+   */
+  std::shared_ptr<const T> selectCacheById(uint32_t id)
+  {
+    uint64_t generation = 0;
+    {
+      std::lock_guard<std::mutex> lock(cacheMutex_);
+
+      // Check if already loaded in cache
+      if (auto cached = selectCache_.find(id))
+      {
+        return cached;
+      }
+      generation = cacheGeneration_;
+    }
+
+    // The cache lock is not held while querying, since the update hook
+    // takes it from inside sqlite3_step() on the writing thread
+    auto selectResult = selectById(id);
+
+    if (!selectResult.has_value())
+    {
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+
+    // A row that was changed while it was being read may be stale, so it
+    // is returned without being cached
+    if (generation != cacheGeneration_)
+    {
+      return std::make_shared<const T>(std::move(selectResult.value()));
+    }
+
+    return selectCache_.insert(id, std::move(selectResult.value()));
+  }
+
+  /*!
+   * \brief Select several records by ID through the select cache
+   *
+   * Cached rows are served from the cache. All misses are fetched with
+   * set-based queries of up to getMaxIdsPerLookup() IDs each and cached.
+   *
+   * \param ids The IDs to retrieve. Should not contain duplicates.
+   * \return The pinned objects that were found, keyed by ID
+   */
+  std::unordered_map<uint32_t, std::shared_ptr<const T>> selectCacheByIds(
+    std::span<const uint32_t> ids)
+  {
+    std::unordered_map<uint32_t, std::shared_ptr<const T>> found;
+    found.reserve(ids.size());
+
+    std::vector<uint32_t> missingIds;
+    uint64_t generation = 0;
+    {
+      std::lock_guard<std::mutex> lock(cacheMutex_);
+      for (uint32_t id : ids)
+      {
+        if (auto cached = selectCache_.find(id))
+        {
+          found.emplace(id, std::move(cached));
+        }
+        else
+        {
+          missingIds.push_back(id);
+        }
+      }
+      generation = cacheGeneration_;
+    }
+
+    if (missingIds.empty())
+    {
+      return found;
+    }
+
+    std::vector<T> rows = selectByIds(missingIds);
+
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    const bool cacheable = generation == cacheGeneration_;
+    for (auto& row : rows)
+    {
+      const uint32_t id = row.id;
+      found.emplace(id,
+                    cacheable
+                      ? selectCache_.insert(id, std::move(row))
+                      : std::make_shared<const T>(std::move(row)));
+    }
+
+    return found;
+  }
+
+  /*!
+   * \brief Configure how the select cache bounds its memory use
+   *
+   * Entries that no longer fit are evicted immediately. The default is an
+   * LRU cache of kDefaultCacheEntries rows without a byte budget.
+   *
+   * \param policy The eviction policy
+   * \param maxEntries The maximum number of cached rows (zero means no
+   *        limit)
+   * \param maxBytes The maximum estimated size of the cached rows in bytes
+   *        (zero means no limit)
+   */
+  void setCachePolicy(CachePolicy policy,
+                      std::size_t maxEntries = kDefaultCacheEntries,
+                      std::size_t maxBytes = 0)
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    selectCache_.configure(policy, maxEntries, maxBytes);
+  }
+
+  /*!
+   * \brief Get the hit, miss and eviction counters of the select cache
+   */
+  CacheStats cacheStats() const
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    return selectCache_.stats();
+  }
+
+  /*!
+   * \brief Choose whether rows inserted through this DAO are copied into
+   *        the select cache
+   *
+   * On by default, so that rows resolved soon after they are written are
+   * served from the cache. Turn it off for bulk loads, so that they do not
+   * evict the rows that are being read. Rows written inside a transaction
+   * that is rolled back are dropped from the cache again.
+   */
+  void setCacheWriteThrough(bool enabled)
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    cacheWriteThrough_ = enabled;
+  }
+
+  /*!
+   * \brief Drop a row from the select cache after it was written
+   *
+   * Called by the database's update hook for every row written to this
+   * table, including writes that bypass the DAO.
+   *
+   * \param id The ID of the written row
+   * \param contentChanged True if an existing row was updated or deleted
+   */
+  void invalidateCachedRow(uint32_t id, bool contentChanged) override
+  {
+    {
+      std::lock_guard<std::mutex> lock(cacheMutex_);
+      selectCache_.erase(id);
+      if (contentChanged)
+      {
+        ++cacheGeneration_;
+      }
+    }
+
+    // Cached rows of other tables may hold a copy of the changed row. New
+    // rows cannot be part of a cached row yet.
+    if (contentChanged)
+    {
+      clearDependentCaches();
+    }
+  }
+
+  /*!
+   * \brief Drop every row from the select cache, and from the caches of
+   *        tables that embed this table's rows
+   */
+  void clearCache() override
+  {
+    {
+      std::lock_guard<std::mutex> lock(cacheMutex_);
+      selectCache_.clear();
+      ++cacheGeneration_;
+    }
+
+    clearDependentCaches();
+  }
+
+  /*!
+   * \brief Register the DAO of a table whose rows embed rows of this table
+   *        as nested objects or repeated fields
+   */
+  void addDependentCache(DAOBase& dependent)
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    dependentCaches_.push_back(&dependent);
+  }
+
+  /*!
+   * \brief Record the metrics of this DAO's statements, including its
+   *        junction table statements, in a registry
+   * \param pRegistry The registry, or nullptr to stop recording
+   */
+  void attachMetrics(MetricsRegistry* pRegistry) override
+  {
+    auto lookup = [pRegistry](std::string_view table, StatementKind kind)
+    { return pRegistry ? &pRegistry->get(table, kind) : nullptr; };
+
+    for (auto kind : {StatementKind::Insert,
+                      StatementKind::InsertMany,
+                      StatementKind::SelectAll,
+                      StatementKind::SelectById,
+                      StatementKind::SelectByIds})
+    {
+      metrics_[static_cast<std::size_t>(kind)].store(
+        lookup(tableName, kind), std::memory_order_release);
+    }
+
+    for (auto& [type, statements] : junctionStmts_)
+    {
+      statements.insertMetrics.store(
+        lookup(statements.tableName, StatementKind::JunctionInsert),
+        std::memory_order_release);
+      statements.selectMetrics.store(
+        lookup(statements.tableName, StatementKind::JunctionSelect),
+        std::memory_order_release);
+    }
+  }
+
+  /*!
+   * \brief Select a single record by ID
+   * \param id The ID of the record to retrieve
+   * \return Optional containing the object if found, empty otherwise
+   */
+  std::optional<T> selectById(uint32_t id)
+  {
+    if (auto reader = db_.leaseReader())
+    {
+      return reader->getDAO<T>().selectById(id);
+    }
+
+    if (!selectByIdStmt_)
+    {
+      LOG_SAFE(
+        pLogger_, spdlog::level::err, "selectById statement not prepared");
+      return std::nullopt;
+    }
+
+    // Reset and bind the ID parameter
+    sqlite3_reset(selectByIdStmt_.get());
+    sqlite3_bind_int64(
+      selectByIdStmt_.get(), 1, static_cast<sqlite3_int64>(id));
+
+    auto results = db_.select<T>(
+      selectByIdStmt_, statementMetrics(StatementKind::SelectById));
+
+    if (results.empty())
+    {
+      return std::nullopt;
+    }
+
+    return results[0];
+  }
+
+  /*!
+   * \brief Select several records by ID with set-based queries
+   *
+   * IDs are bound to `WHERE id IN (...)` statements in chunks of up to
+   * getMaxIdsPerLookup() IDs. Chunk sizes are powers of two, so only a
+   * handful of statements are ever prepared.
+   *
+   * \param ids The IDs of the records to retrieve
+   * \return The objects that were found, in no particular order
+   */
+  std::vector<T> selectByIds(std::span<const uint32_t> ids)
+  {
+    if (auto reader = db_.leaseReader())
+    {
+      return reader->getDAO<T>().selectByIds(ids);
+    }
+
+    std::vector<T> results;
+    results.reserve(ids.size());
+
+    std::span<const uint32_t> remaining = ids;
+    while (!remaining.empty())
+    {
+      const std::size_t count =
+        std::bit_floor(std::min(remaining.size(), maxIdsPerLookup_));
+      auto chunk = remaining.first(count);
+      remaining = remaining.subspan(count);
+
+      PreparedSQLStmt* stmt = getSelectByIdsStatement(count);
+      if (!stmt)
+      {
+        continue;
+      }
+
+      sqlite3_reset(stmt->get());
+      int paramIndex = 1;
+      for (uint32_t id : chunk)
+      {
+        sqlite3_bind_int64(
+          stmt->get(), paramIndex++, static_cast<sqlite3_int64>(id));
+      }
+
+      auto rows =
+        db_.select<T>(*stmt, statementMetrics(StatementKind::SelectByIds));
+      std::move(rows.begin(), rows.end(), std::back_inserter(results));
+    }
+
+    return results;
+  }
+
+  uint32_t incrementIdCounter()
+  {
+    return ++idCounter_;
+  }
+
+private:
+  /*!
+   * \brief Get the metrics of one of this table's statements
+   * \return The metrics, or nullptr if metrics are disabled
+   */
+  StatementMetrics* statementMetrics(StatementKind kind) const
+  {
+#ifdef CPP_SQLITE_DISABLE_METRICS
+    (void)kind;
+    return nullptr;
+#else
+    return metrics_[static_cast<std::size_t>(kind)].load(
+      std::memory_order_acquire);
+#endif
+  }
+
+  /*!
+   * \brief Add an object to whichever buffer backend is active
+   */
+  template <typename U>
+  bool pushToBuffer(U&& obj)
+  {
+    markBufferUsed();
+    if (pRingBuffer_)
+    {
+      return pRingBuffer_->push(std::forward<U>(obj));
+    }
+
+    std::lock_guard<std::mutex> lock(bufferMutex_);
+    writeBuffer_.push_back(std::forward<U>(obj));
+    recordBufferedCount();
+    return true;
+  }
+
+  /*!
+   * \brief Pin the buffer backend once a row is buffered
+   *
+   * Only stores on first use, so producers do not keep writing to a
+   * shared cache line.
+   */
+  void markBufferUsed()
+  {
+    if (!bufferUsed_.load(std::memory_order_relaxed))
+    {
+      bufferUsed_.store(true, std::memory_order_release);
+    }
+  }
+
+  /*!
+   * \brief Publish the size of the mutex-guarded write buffer
+   * Must be called with bufferMutex_ held.
+   */
+  void recordBufferedCount()
+  {
+    std::size_t count = writeBuffer_.size();
+    bufferedCount_.store(count, std::memory_order_relaxed);
+
+    if (count > highWaterMark_.load(std::memory_order_relaxed))
+    {
+      highWaterMark_.store(count, std::memory_order_relaxed);
+    }
+  }
+
+  /*!
+   * \brief Insert one batch of the flush buffer inside a transaction
+   * \param rows The rows of the batch
+   * \param flushResult The result that is updated with the batch outcome
+   */
+  void flushBatch(std::span<T> rows, FlushResult& flushResult)
+  {
+    Transaction transaction{db_, pLogger_};
+
+    std::vector<uint32_t> failedIds;
+    std::optional<std::size_t> succeeded =
+      insertRows(rows, failedIds, transaction.isActive());
+
+    if (!succeeded)
+    {
+      // SQLite rolled back the whole transaction after a failed row, so
+      // none of the batch was written
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "Flush of {} rows for table {} was rolled back by SQLite",
+               rows.size(),
+               tableName);
+
+      ++flushResult.transactions;
+      for (const auto& row : rows)
+      {
+        flushResult.failedIds.push_back(row.id);
+      }
+      return;
+    }
+
+    // If the transaction could not be opened the rows were written in
+    // autocommit mode, so their individual results are final.
+    if (transaction.isActive())
+    {
+      ++flushResult.transactions;
+
+      if (!transaction.commit())
+      {
+        LOG_SAFE(pLogger_,
+                 spdlog::level::err,
+                 "Could not commit flush of {} rows for table {}",
+                 rows.size(),
+                 tableName);
+
+        for (const auto& row : rows)
+        {
+          flushResult.failedIds.push_back(row.id);
+        }
+        return;
+      }
+    }
+
+    flushResult.succeeded += *succeeded;
+    flushResult.failedIds.insert(
+      flushResult.failedIds.end(), failedIds.begin(), failedIds.end());
+  }
+
+  /*!
+   * \brief Insert a span of rows, using multi-row INSERT statements when
+   *        the row type allows it
+   * \param rows The rows to insert
+   * \param failedIds Receives the IDs of rows that could not be inserted
+   * \param inTransaction True if the rows are written inside a transaction
+   * \return The number of inserted rows, or an empty optional if SQLite
+   *         rolled back the transaction after a failed row. The remaining
+   *         rows are then not attempted, since they would be written in
+   *         autocommit mode.
+   */
+  std::optional<std::size_t> insertRows(std::span<T> rows,
+                                        std::vector<uint32_t>& failedIds,
+                                        bool inTransaction)
+  {
+    if constexpr (FlatTransferObject<T>)
+    {
+      if (maxRowsPerInsert_ > 1)
+      {
+        return insertMultiRow(rows, failedIds, inTransaction);
+      }
+    }
+
+    std::size_t succeeded = 0;
+    for (auto& row : rows)
+    {
+      if (insert(row))
+      {
+        ++succeeded;
+      }
+      else if (transactionRolledBack(inTransaction))
+      {
+        return std::nullopt;
+      }
+      else
+      {
+        failedIds.push_back(row.id);
+      }
+    }
+    return succeeded;
+  }
+
+  /*!
+   * \brief Check whether SQLite ended the surrounding transaction
+   *
+   * Errors such as SQLITE_FULL, SQLITE_IOERR, SQLITE_BUSY or SQLITE_NOMEM,
+   * and RAISE(ROLLBACK) in a trigger, can roll back the whole transaction
+   * rather than just the failed statement.
+   *
+   * \param inTransaction True if a transaction was open before the write
+   */
+  bool transactionRolledBack(bool inTransaction) const
+  {
+    return inTransaction && sqlite3_get_autocommit(&db_.getRawDB()) != 0;
+  }
+
+  /*!
+   * \brief Insert rows in chunks that are each bound to one multi-row
+   *        INSERT statement and executed with a single sqlite3_step
+   *
+   * Chunk sizes are powers of two so that only a handful of statements
+   * are ever prepared per table. If a chunk fails, it is retried row by
+   * row to find out which rows were rejected.
+   *
+   * \return The number of inserted rows, or an empty optional if SQLite
+   *         rolled back the surrounding transaction
+   */
+  std::optional<std::size_t> insertMultiRow(std::span<T> rows,
+                                            std::vector<uint32_t>& failedIds,
+                                            bool inTransaction)
+  {
+    if (!insertStmt_)
+    {
+      for (const auto& row : rows)
+      {
+        failedIds.push_back(row.id);
+      }
+      return 0;
+    }
+
+    // Assign IDs up front so rows with invalid IDs never reach a statement
+    multiRowScratch_.clear();
+    for (auto& row : rows)
+    {
+      if (assignId(row))
+      {
+        multiRowScratch_.push_back(&row);
+      }
+      else
+      {
+        failedIds.push_back(row.id);
+      }
+    }
+
+    std::size_t succeeded = 0;
+    std::span<T* const> remaining{multiRowScratch_};
+    while (!remaining.empty())
+    {
+      std::size_t count =
+        std::bit_floor(std::min(remaining.size(), maxRowsPerInsert_));
+      auto chunk = remaining.first(count);
+      remaining = remaining.subspan(count);
+
+      if (count > 1)
+      {
+        PreparedSQLStmt* stmt = getMultiRowInsertStatement(count);
+        if (stmt &&
+            db_.insertMany(
+              *stmt, chunk, statementMetrics(StatementKind::InsertMany)))
+        {
+          for (T* row : chunk)
+          {
+            writeThrough(*row);
+          }
+          succeeded += count;
+          continue;
+        }
+
+        if (transactionRolledBack(inTransaction))
+        {
+          return std::nullopt;
+        }
+      }
+
+      // A single statement is atomic, so nothing from a failed chunk was
+      // written. Fall back to one row at a time.
+      for (T* row : chunk)
+      {
+        if (db_.insert(
+              insertStmt_, *row, statementMetrics(StatementKind::Insert)))
+        {
+          writeThrough(*row);
+          ++succeeded;
+        }
+        else if (transactionRolledBack(inTransaction))
+        {
+          return std::nullopt;
+        }
+        else
+        {
+          failedIds.push_back(row->id);
+        }
+      }
+    }
+
+    return succeeded;
+  }
+
+  /*!
+   * \brief Get (or lazily prepare) the INSERT statement for a given
+   *        number of rows
+   * \return The statement, or nullptr if it could not be prepared
+   */
+  PreparedSQLStmt* getMultiRowInsertStatement(std::size_t rowCount)
+  {
+    auto it = multiRowInsertStmts_.find(rowCount);
+    if (it != multiRowInsertStmts_.end())
+    {
+      return &it->second;
+    }
+
+    PreparedSQLStmt stmt{nullptr, sqlite3_finalize};
+    if (!prepareCachedStatement(
+          generateInsertSQL(rowCount), stmt, "multi-row insert"))
+    {
+      return nullptr;
+    }
+
+    auto result = multiRowInsertStmts_.emplace(rowCount, std::move(stmt));
+    return &result.first->second;
+  }
+
+  /*!
+   * \brief Assign (or validate) the ID of a row that is about to be
+   *        inserted
+   * \return False if the ID was manually set to a value that may
+   *         conflict with IDs handed out by this DAO
+   */
+  bool assignId(T& data)
+  {
+    if (data.id == std::numeric_limits<uint32_t>::max())
+    {
+      data.id = incrementIdCounter();
+    }
+    // If the ID has been manually specified by the user without using
+    // the class-given `incrementIdCounter()` function, we want to log
+    // an error and fail to execute the insert.
+    else if (data.id <= idCounter_)
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "The identifier for this transfer object has been manually set "
+               "outside of the context of the DataAccessObject");
+      return false;
+    }
+    else
+    {
+      // Manual ID is valid and higher than counter - update counter to prevent
+      // conflicts
+      LOG_SAFE(pLogger_,
+               spdlog::level::warn,
+               "Manual ID {} is higher than current counter {}. Updating "
+               "counter to prevent future conflicts.",
+               data.id,
+               idCounter_);
+      idCounter_ = data.id;
+    }
+
+    return true;
+  }
+
+  /*!
+   * \brief Prepare a statement against this DAO's database
+   * \param sql The SQL to prepare
+   * \param stmt Receives the prepared statement
+   * \param description A short name of the statement used in log messages
+   * \return True if the statement was prepared
+   */
+  bool prepareStatement(std::string_view sql,
+                        PreparedSQLStmt& stmt,
+                        std::string_view description)
+  {
+    LOG_SAFE(pLogger_, spdlog::level::debug, "{}", sql);
+
+    sqlite3_stmt* rawPtr = nullptr;
+    int result = sqlite3_prepare_v2(&(db_.getRawDB()),
+                                    sql.data(),
+                                    static_cast<int>(sql.size()),
+                                    &rawPtr,
+                                    nullptr);
+
+    if (result != SQLITE_OK)
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "Could not prepare {} statement for table {}. SQLITE code: {}",
+               description,
+               tableName,
+               result);
+      return false;
+    }
+
+    stmt.reset(rawPtr);
+    return true;
   }
 
-  std::optional<std::reference_wrapper<const T>> selectCacheById(uint32_t id)
+  /*!
+   * \brief Prepare one of the statements this DAO keeps for its lifetime
+   *        and register it with the database, so that slow queries are
+   *        attributed to it
+   * \param sql The SQL to prepare
+   * \param stmt Receives the prepared statement
+   * \param description A short name of the statement, used in log messages
+   *        and slow query entries
+   * \param table The table reported in slow query entries
+   * \return True if the statement was prepared
+   */
+  bool prepareCachedStatement(std::string_view sql,
+                              PreparedSQLStmt& stmt,
+                              std::string_view description,
+                              std::string_view table = tableName)
   {
-    // Check if already loaded in cache
-    auto resultIt = selectCache_.find(id);
-    if (resultIt != selectCache_.end())
-    {
-      return std::cref(resultIt->second);
-    }
-
-    auto selectResult = selectById(id);
-
-    if (!selectResult.has_value())
+    if (!prepareStatement(sql, stmt, description))
     {
-      return std::nullopt;
+      return false;
     }
 
-    auto result = selectCache_.emplace(id, std::move(selectResult.value()));
-    return std::cref(result.first->second);
+    db_.registerStatement(stmt.get(), table, description);
+    return true;
   }
 
   /*!
-   * \brief Select a single record by ID
-   * \param id The ID of the record to retrieve
-   * \return Optional containing the object if found, empty otherwise
+   * \brief Get (or lazily prepare) the SELECT statement that loads a given
+   *        number of rows by ID
+   * \return The statement, or nullptr if it could not be prepared
    */
-  std::optional<T> selectById(uint32_t id)
+  PreparedSQLStmt* getSelectByIdsStatement(std::size_t idCount)
   {
-    if (!selectByIdStmt_)
+    auto it = selectByIdsStmts_.find(idCount);
+    if (it != selectByIdsStmts_.end())
     {
-      LOG_SAFE(
-        pLogger_, spdlog::level::err, "selectById statement not prepared");
-      return std::nullopt;
+      return &it->second;
     }
 
-    // Reset and bind the ID parameter
-    sqlite3_reset(selectByIdStmt_.get());
-    sqlite3_bind_int64(
-      selectByIdStmt_.get(), 1, static_cast<sqlite3_int64>(id));
-
-    auto results = db_.select<T>(selectByIdStmt_);
+    std::string sql{TableSQL<T>::selectByIdsPrefix.view()};
+    for (std::size_t i = 0; i < idCount; ++i)
+    {
+      sql += i == 0 ? "?" : ", ?";
+    }
+    sql += ");";
 
-    if (results.empty())
+    PreparedSQLStmt stmt{nullptr, sqlite3_finalize};
+    if (!prepareCachedStatement(sql, stmt, "SELECT BY IDS"))
     {
-      return std::nullopt;
+      return nullptr;
     }
 
-    return results[0];
+    auto result = selectByIdsStmts_.emplace(idCount, std::move(stmt));
+    return &result.first->second;
   }
 
-  uint32_t incrementIdCounter()
+  /*!
+   * \brief Prepare a private copy of the select all statement for a cursor
+   * \return The prepared statement, or a null statement on failure
+   */
+  PreparedSQLStmt prepareCursorStatement()
   {
-    return ++idCounter_;
-  }
+    PreparedSQLStmt stmt{nullptr, sqlite3_finalize};
 
-private:
-  // Helper function to map C++ types to SQL types
-  template <isSupportedDBType FieldType>
-  constexpr std::string getSQLType()
-  {
-    if constexpr (isIntegral<FieldType>)
-    {
-      return "INTEGER";
-    }
-    else if constexpr (floatingPoint<FieldType>)
+    if (!selectAllStmt_ ||
+        !prepareStatement(sqlite3_sql(selectAllStmt_.get()), stmt, "cursor"))
     {
-      return "FLOAT";
-    }
-    else if constexpr (std::is_same_v<FieldType, std::string>)
-    {
-      return "TEXT";
-    }
-    else if constexpr (isBlob<FieldType>)
-    {
-      return "BLOB";
-    }
-    else
-    {
-      return "BLOB";  // Default for unknown types
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "Could not open a cursor on table {}",
+               tableName);
     }
+
+    return stmt;
   }
 
   /*!
-   * \brief Create the string that is used to generate the SQL
-   *        CREATE TABLE command
-   * \return A string for the table creation command.
+   * \brief Create the DAOs (and so the tables) of nested transfer objects
+   *
+   * The SELECT statements join the tables of nested objects, so those
+   * tables must exist before the statements are prepared.
    */
-  std::string generateCreateTableSQL()
+  bool registerNestedDAOs()
   {
-    std::string sql{};
-    sql = "CREATE TABLE IF NOT EXISTS " + tableName_ + " (";
-    std::string foreignKeys;
-
-    bool first = true;
+    bool success = true;
 
-    // Process public and inherited members
     boost::mp11::mp_for_each<boost::describe::describe_members<
       T,
       boost::describe::mod_inherited | boost::describe::mod_public>>(
       [&](auto D)
       {
-        // Get member type and map to SQL type
         using memberType = std::remove_cv_t<
           std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
 
         if constexpr (IsRepeatedFieldTransferObject<memberType>)
         {
-          using fieldType = RepeatedFieldOfType<memberType>;
-          std::string dataName = stripNamespace(
-            boost::typeindex::type_id<fieldType>().pretty_name());
-          std::string mapTable = "CREATE TABLE IF NOT EXISTS " + tableName_ +
-                                 "_" + dataName + "(" + tableName_ +
-                                 "_id INTEGER, " + dataName + "_id INTEGER); ";
-
-          char* err_msg = 0;
-
-          LOG_SAFE(
-            pLogger_, spdlog::level::trace, "Create Table: {}", mapTable);
-
-          if (sqlite3_exec(&db_.getRawDB(), mapTable.c_str(), 0, 0, &err_msg) !=
-              SQLITE_OK)
-          {
-            LOG_SAFE(pLogger_, spdlog::level::err, "SQL error: {}", err_msg);
-          }
+          db_.getDAO<RepeatedFieldOfType<memberType>>().addDependentCache(
+            *this);
         }
-        else
+        else if constexpr (ValidTransferObject<memberType>)
         {
-          if (!first)
-            sql += ", ";
-
-          // Get member name
-          sql += D.name;
-
-          // Handle ForeignKey - treat it like a foreign key ID field
-          if constexpr (IsForeignKey<memberType>)
-          {
-            using ReferencedType = ForeignKeyType<memberType>;
-            std::string refTableName = stripNamespace(
-              boost::typeindex::type_id<ReferencedType>().pretty_name());
-
-            sql += "_id INTEGER";
-            foreignKeys += ", FOREIGN KEY (" + std::string(D.name) +
-                           "_id) REFERENCES " + refTableName + "(id)";
-          }
-          // If the field is, itself, another transfer object, we treat
-          // this field in the current table as a key to the table
-          // that the child object presumably exists at.
-          else if constexpr (ValidTransferObject<memberType>)
-          {
-            using idType = decltype(std::declval<memberType>().id);
-            sql += "_id " + getSQLType<idType>();
-
-            foreignKeys +=
-              ", FOREIGN KEY (" + std::string(D.name) + "_id) REFERENCES " +
-              stripNamespace(
-                boost::typeindex::type_id<memberType>().pretty_name()) +
-              "(id)";
-          }
-          else if constexpr (isSupportedDBType<memberType>)
-          {
-            sql += " " + getSQLType<memberType>();
-
-            // Add PRIMARY KEY for id field
-            if (std::string(D.name) == "id")
-            {
-              sql += " PRIMARY KEY";
-            }
-          }
-
-          first = false;
+          auto& nestedDAO = db_.getDAO<memberType>();
+          nestedDAO.addDependentCache(*this);
+          success &= nestedDAO.isInitialized();
         }
       });
 
-    sql += foreignKeys;
-
-    sql += ");";
-    return sql;
-  }
-
-  bool prepareSQLStatements()
-  {
-    return prepareInsertStatement() && prepareSelectStatements();
+    return success;
   }
 
-  bool prepareInsertStatement()
+  /*!
+   * \brief Copy an inserted row into the select cache if write-through is
+   *        enabled
+   */
+  void writeThrough(const T& row)
   {
-    std::string insertQuery = generateInsertSQL();
-
-    LOG_SAFE(pLogger_, spdlog::level::debug, insertQuery);
-
-    sqlite3_stmt* rawPtr = nullptr;
-    int result = sqlite3_prepare_v2(
-      &(db_.getRawDB()), insertQuery.c_str(), -1, &rawPtr, nullptr);
-
-    if (result != SQLITE_OK)
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    if (cacheWriteThrough_)
     {
-      LOG_SAFE(
-        pLogger_,
-        spdlog::level::err,
-        "Could not prepare insert statement for table {}. SQLITE code: {}",
-        tableName_,
-        result);
-      return false;
+      selectCache_.insert(row.id, T{row});
     }
-
-    insertStmt_.reset(rawPtr);
-    return true;
   }
 
-  bool prepareSelectStatements()
+  /*!
+   * \brief Clear the caches of every table that embeds this table's rows
+   */
+  void clearDependentCaches()
   {
-    // Prepare SELECT ALL statement
-    std::string selectAllQuery = generateSelectAllSQL();
-    LOG_SAFE(pLogger_, spdlog::level::debug, selectAllQuery);
-
-    sqlite3_stmt* rawPtr = nullptr;
-    int result = sqlite3_prepare_v2(
-      &(db_.getRawDB()), selectAllQuery.c_str(), -1, &rawPtr, nullptr);
-
-    if (result != SQLITE_OK)
+    std::vector<DAOBase*> dependents;
     {
-      LOG_SAFE(
-        pLogger_,
-        spdlog::level::err,
-        "Could not prepare SELECT ALL statement for table {}. SQLITE code: {}",
-        tableName_,
-        result);
-      return false;
+      std::lock_guard<std::mutex> lock(cacheMutex_);
+      dependents = dependentCaches_;
     }
 
-    selectAllStmt_.reset(rawPtr);
-
-    // Prepare SELECT BY ID statement
-    std::string selectByIdQuery = generateSelectByIdSQL();
-    LOG_SAFE(pLogger_, spdlog::level::debug, selectByIdQuery);
+    for (DAOBase* dependent : dependents)
+    {
+      dependent->clearCache();
+    }
+  }
 
-    rawPtr = nullptr;
-    result = sqlite3_prepare_v2(
-      &(db_.getRawDB()), selectByIdQuery.c_str(), -1, &rawPtr, nullptr);
+  bool prepareSQLStatements()
+  {
+    return prepareInsertStatement() && prepareSelectStatements();
+  }
 
-    if (result != SQLITE_OK)
+  bool prepareInsertStatement()
+  {
+    if (!prepareCachedStatement(TableSQL<T>::insert, insertStmt_, "insert"))
     {
-      LOG_SAFE(pLogger_,
-               spdlog::level::err,
-               "Could not prepare SELECT BY ID statement for table {}. SQLITE "
-               "code: {}",
-               tableName_,
-               result);
       return false;
     }
 
-    selectByIdStmt_.reset(rawPtr);
+    maxRowsPerInsert_ =
+      std::min(kDefaultMaxRowsPerInsert, maxRowsForVariableLimit());
+    maxIdsPerLookup_ = std::min<std::size_t>(
+      kDefaultMaxIdsPerLookup,
+      sqlite3_limit(&(db_.getRawDB()), SQLITE_LIMIT_VARIABLE_NUMBER, -1));
     return true;
   }
 
   /*!
-   * \brief Generate SELECT ALL SQL statement
-   * \return The SQL string for selecting all records
+   * \brief Prepare the junction table statements for every repeated field
+   *
+   * The SQL is built once here so that inserting or loading parent rows
+   * never has to concatenate it again.
    */
-  std::string generateSelectAllSQL()
+  bool prepareJunctionStatements()
   {
-    std::ostringstream sql;
-    sql << "SELECT ";
-
-    std::vector<std::string> columns;
+    bool success = true;
 
-    // Process public members to build column list
     boost::mp11::mp_for_each<boost::describe::describe_members<
       T,
       boost::describe::mod_inherited | boost::describe::mod_public>>(
@@ -440,109 +1519,98 @@ private:
         using memberType = std::remove_cv_t<
           std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
 
-        // Skip repeated field transfer objects (they're in separate tables)
         if constexpr (IsRepeatedFieldTransferObject<memberType>)
         {
-          // Skip - these are handled separately
-        }
-        else if constexpr (IsForeignKey<memberType>)
-        {
-          // ForeignKey fields are stored as "_id" columns
-          columns.push_back(std::string(D.name) + "_id");
-        }
-        else if constexpr (ValidTransferObject<memberType>)
-        {
-          columns.push_back(std::string(D.name) + "_id");
-        }
-        else if constexpr (isSupportedDBType<memberType>)
-        {
-          columns.push_back(std::string(D.name));
+          using fieldType = RepeatedFieldOfType<memberType>;
+
+          auto typeIdx = std::type_index(typeid(fieldType));
+          if (junctionStmts_.contains(typeIdx))
+          {
+            return;
+          }
+
+          // Constructed in place, since the metrics pointers cannot move
+          auto& statements = junctionStmts_[typeIdx];
+          statements.tableName = JunctionSQL<T, fieldType>::tableName;
+          success &=
+            prepareCachedStatement(JunctionSQL<T, fieldType>::insert,
+                                   statements.insertStmt,
+                                   "junction insert",
+                                   statements.tableName);
+
+          // The child table may not exist yet, so the SELECT statements
+          // are only prepared when they are first used
+          statements.selectPrefix = JunctionSQL<T, fieldType>::selectPrefix;
+          statements.selectSuffix = JunctionSQL<T, fieldType>::selectSuffix;
         }
       });
 
-    // Build the column names part
-    bool first = true;
-    for (const auto& column : columns)
-    {
-      if (!first)
-        sql << ", ";
-      sql << column;
-      first = false;
-    }
-
-    sql << " FROM " << tableName_ << ";";
-    return sql.str();
+    return success;
   }
 
   /*!
-   * \brief Generate SELECT BY ID SQL statement
-   * \return The SQL string for selecting a record by ID
+   * \brief The largest number of rows one INSERT statement can bind
+   *        without exceeding SQLITE_MAX_VARIABLE_NUMBER host parameters
    */
-  std::string generateSelectByIdSQL()
+  std::size_t maxRowsForVariableLimit()
   {
-    std::ostringstream sql;
-    sql << "SELECT ";
-
-    std::vector<std::string> columns;
-
-    // Process public members to build column list
-    boost::mp11::mp_for_each<boost::describe::describe_members<
-      T,
-      boost::describe::mod_inherited | boost::describe::mod_public>>(
-      [&](auto D)
-      {
-        using memberType = std::remove_cv_t<
-          std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
-
-        // Skip repeated field transfer objects
-        if constexpr (IsRepeatedFieldTransferObject<memberType>)
-        {
-          // Skip - these are handled separately
-        }
-        else if constexpr (IsForeignKey<memberType>)
-        {
-          // ForeignKey fields are stored as "_id" columns
-          columns.push_back(std::string(D.name) + "_id");
-        }
-        else if constexpr (ValidTransferObject<memberType>)
-        {
-          columns.push_back(std::string(D.name) + "_id");
-        }
-        else if constexpr (isSupportedDBType<memberType>)
-        {
-          columns.push_back(std::string(D.name));
-        }
-      });
+    int variableLimit =
+      sqlite3_limit(&(db_.getRawDB()), SQLITE_LIMIT_VARIABLE_NUMBER, -1);
+    return std::max<std::size_t>(
+      static_cast<std::size_t>(variableLimit) /
+        std::max<std::size_t>(insertColumnCount(), 1),
+      1);
+  }
 
-    // Build the column names part
-    bool first = true;
-    for (const auto& column : columns)
+  bool prepareSelectStatements()
+  {
+    // Prepare SELECT ALL statement
+    if (!prepareCachedStatement(
+          TableSQL<T>::selectAll, selectAllStmt_, "SELECT ALL"))
     {
-      if (!first)
-        sql << ", ";
-      sql << column;
-      first = false;
+      return false;
     }
 
-    sql << " FROM " << tableName_ << " WHERE id = ?;";
-    return sql.str();
+    // Prepare SELECT BY ID statement
+    return prepareCachedStatement(
+      TableSQL<T>::selectById, selectByIdStmt_, "SELECT BY ID");
   }
 
   /*!
-   * \brief Create the string that prepares an insert statement.
+   * \brief Create the string that prepares an insert statement for a
+   *        given number of rows
    *
+   * \param rowCount The number of rows (VALUES groups) the statement
+   *        inserts
    * \return The string for a prepared insert statement for a DB
    *         table.
    */
-  std::string generateInsertSQL()
+  static std::string generateInsertSQL(std::size_t rowCount)
   {
-    std::ostringstream sql;
-    sql << "INSERT INTO " << tableName_ << " (";
+    constexpr std::string_view prefix = TableSQL<T>::insertPrefix;
+    constexpr std::string_view values = TableSQL<T>::insertValues;
 
-    std::vector<std::string> columns;
-    std::vector<std::string> placeholders;
+    std::string sql;
+    sql.reserve(prefix.size() + rowCount * (values.size() + 2));
+    sql += prefix;
+    for (std::size_t row = 0; row < rowCount; ++row)
+    {
+      if (row > 0)
+      {
+        sql += ", ";
+      }
+      sql += values;
+    }
+    sql += ';';
+    return sql;
+  }
 
-    // Process public members to build column list
+  /*!
+   * \brief The number of columns bound by one row of an insert statement
+   */
+  static constexpr std::size_t insertColumnCount()
+  {
+    std::size_t count = 0;
     boost::mp11::mp_for_each<boost::describe::describe_members<
       T,
       boost::describe::mod_inherited | boost::describe::mod_public>>(
@@ -551,50 +1619,135 @@ private:
         using memberType = std::remove_cv_t<
           std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
 
-        // Handle ForeignKey
-        if constexpr (IsForeignKey<memberType>)
-        {
-          columns.push_back(std::string(D.name) + "_id");
-          placeholders.push_back("?");
-        }
-        // If the field is another transfer object, we use the foreign key
-        // column name
-        else if constexpr (ValidTransferObject<memberType>)
-        {
-          columns.push_back(std::string(D.name) + "_id");
-          placeholders.push_back("?");
-        }
-        else if constexpr (isSupportedDBType<memberType>)
+        if constexpr (!IsRepeatedFieldTransferObject<memberType>)
         {
-          columns.push_back(std::string(D.name));
-          placeholders.push_back("?");
+          ++count;
         }
       });
+    return count;
+  }
+
+  /*!
+   * \brief Create the junction table that links this table to the table
+   *        of a repeated field
+   *
+   * Junction tables are WITHOUT ROWID tables keyed by (parent_id,
+   * child_id), so the children of a parent are found with an index range
+   * scan. Junction tables created without a key by earlier versions are
+   * rebuilt with the key; duplicate links are dropped.
+   *
+   * \tparam Child The type of the repeated field
+   * \return True if the table exists with the expected layout
+   */
+  template <ValidTransferObject Child>
+  bool createJunctionTable()
+  {
+    constexpr std::string_view junctionTable =
+      JunctionSQL<T, Child>::tableName;
+    constexpr const char* createSQL =
+      JunctionSQL<T, Child>::createTable.c_str();
+
+    if (!isLegacyJunctionTable(junctionTable))
+    {
+      return executeSQL(createSQL);
+    }
+
+    if (sqlite3_db_readonly(&db_.getRawDB(), "main") == 1)
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::warn,
+               "Junction table {} has no primary key, but the database is "
+               "read-only and it cannot be migrated",
+               junctionTable);
+      return true;
+    }
+
+    // Migrations are rare, so their SQL is built here
+    const std::string table{junctionTable};
+    const std::string legacyTable = table + "_legacy";
+    const std::string parentColumn = std::string{tableName} + "_id";
+    const std::string childColumn = std::string{sqlTableName<Child>} + "_id";
+
+    Transaction transaction{db_, pLogger_};
+    bool migrated =
+      executeSQL(
+        ("ALTER TABLE " + table + " RENAME TO " + legacyTable + ";").c_str()) &&
+      executeSQL(createSQL) &&
+      executeSQL(("INSERT OR IGNORE INTO " + table + " SELECT " +
+                  parentColumn + ", " + childColumn + " FROM " + legacyTable +
+                  " WHERE " + parentColumn + " IS NOT NULL AND " +
+                  childColumn + " IS NOT NULL;")
+                   .c_str()) &&
+      executeSQL(("DROP TABLE " + legacyTable + ";").c_str());
+
+    // On failure the transaction is rolled back when it goes out of scope
+    if (!migrated || !transaction.commit())
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "Could not migrate junction table {}",
+               junctionTable);
+      return false;
+    }
 
-    // Build the column names part
-    bool first = true;
-    for (const auto& column : columns)
+    LOG_SAFE(pLogger_,
+             spdlog::level::info,
+             "Migrated junction table {} to a keyed WITHOUT ROWID table",
+             junctionTable);
+    return true;
+  }
+
+  /*!
+   * \brief Check whether a junction table exists with the unkeyed layout
+   *        of earlier versions
+   */
+  bool isLegacyJunctionTable(std::string_view junctionTable)
+  {
+    PreparedSQLStmt stmt{nullptr, sqlite3_finalize};
+    if (!prepareStatement(
+          "SELECT sql FROM sqlite_master WHERE type = 'table' AND name = ?;",
+          stmt,
+          "schema lookup"))
     {
-      if (!first)
-        sql << ", ";
-      sql << column;
-      first = false;
+      return false;
     }
 
-    sql << ") VALUES (";
+    sqlite3_bind_text(stmt.get(),
+                      1,
+                      junctionTable.data(),
+                      static_cast<int>(junctionTable.length()),
+                      SQLITE_TRANSIENT);
 
-    // Build the placeholders part
-    first = true;
-    for (const auto& placeholder : placeholders)
+    if (sqlite3_step(stmt.get()) != SQLITE_ROW)
     {
-      if (!first)
-        sql << ", ";
-      sql << placeholder;
-      first = false;
+      return false;
     }
 
-    sql << ");";
-    return sql.str();
+    const unsigned char* text = sqlite3_column_text(stmt.get(), 0);
+    return text && std::string(reinterpret_cast<const char*>(text))
+                         .find("WITHOUT ROWID") == std::string::npos;
+  }
+
+  /*!
+   * \brief Execute a statement that returns no rows
+   * \return True if the statement succeeded
+   */
+  bool executeSQL(const char* sql)
+  {
+    LOG_SAFE(pLogger_, spdlog::level::trace, "Executing: {}", sql);
+
+    char* errMsg = nullptr;
+    int result =
+      sqlite3_exec(&db_.getRawDB(), sql, nullptr, nullptr, &errMsg);
+    if (result != SQLITE_OK)
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "SQL error: {}",
+               errMsg ? errMsg : sqlite3_errstr(result));
+    }
+    sqlite3_free(errMsg);
+    return result == SQLITE_OK;
   }
 
   /*!
@@ -603,10 +1756,26 @@ private:
    */
   bool executeCreateStmt()
   {
-    std::string createQuery = generateCreateTableSQL();
+    bool success = true;
+    boost::mp11::mp_for_each<boost::describe::describe_members<
+      T,
+      boost::describe::mod_inherited | boost::describe::mod_public>>(
+      [&](auto D)
+      {
+        using memberType = std::remove_cv_t<
+          std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+
+        if constexpr (IsRepeatedFieldTransferObject<memberType>)
+        {
+          success &=
+            createJunctionTable<RepeatedFieldOfType<memberType>>();
+        }
+      });
+
+    constexpr const char* createQuery = TableSQL<T>::createTable.c_str();
 
     LOG_SAFE(pLogger_, spdlog::level::trace, "Executing: {}", createQuery);
-    int result = sqlite3_exec(&db_.getRawDB(), createQuery.c_str(), 0, 0, 0);
+    int result = sqlite3_exec(&db_.getRawDB(), createQuery, 0, 0, 0);
     if (result != SQLITE_OK)
     {
       LOG_SAFE(pLogger_,
@@ -615,36 +1784,113 @@ private:
                result);
       return false;
     }
-    return true;
+    return success;
   }
 
-  //! The name of the table accessed by this object.
-  std::string tableName_;
-
   //!< The prepared statement to facilitate inserting data into the database
   PreparedSQLStmt insertStmt_;
 
+  //!< Multi-row insert statements, keyed by the number of rows they insert
+  std::unordered_map<std::size_t, PreparedSQLStmt> multiRowInsertStmts_;
+
+  //!< Rows of the current multi-row flush (reused between flushes)
+  std::vector<T*> multiRowScratch_;
+
   //!< The prepared statement for SELECT ALL queries
   PreparedSQLStmt selectAllStmt_;
 
   //!< The prepared statement for SELECT BY ID queries
   PreparedSQLStmt selectByIdStmt_;
 
+  //! SELECT BY IDS statements, keyed by the number of IDs they bind
+  std::unordered_map<std::size_t, PreparedSQLStmt> selectByIdsStmts_;
+
+  //! The cached statements for one junction table
+  struct JunctionStatements
+  {
+    //!< The name of the junction table
+    std::string_view tableName;
+
+    //!< Links a parent row to a child row
+    PreparedSQLStmt insertStmt{nullptr, sqlite3_finalize};
+
+    //!< Start of the child SELECT, up to the opening parenthesis of the
+    //!< IN list of parent IDs
+    std::string_view selectPrefix;
+
+    //!< End of the child SELECT, from the closing parenthesis of the IN
+    //!< list of parent IDs
+    std::string_view selectSuffix;
+
+    //!< Child SELECT statements, keyed by the number of parent IDs they bind
+    std::unordered_map<std::size_t, PreparedSQLStmt> selectStmts;
+
+    //!< Metrics of the INSERT statement, if enabled
+    std::atomic<StatementMetrics*> insertMetrics{nullptr};
+
+    //!< Metrics of the SELECT statements, if enabled
+    std::atomic<StatementMetrics*> selectMetrics{nullptr};
+  };
+
+  //!< Junction table statements, keyed by the repeated field's type
+  std::unordered_map<std::type_index, JunctionStatements> junctionStmts_;
+
+  //! Metrics of this table's statements, indexed by StatementKind. Null
+  //! while metrics are disabled.
+  std::array<std::atomic<StatementMetrics*>, kStatementKindCount> metrics_;
+
   //! Write buffer - writers add here (protected by mutex)
   std::vector<T> writeBuffer_;
 
   //! Flush buffer - DB thread reads from here (no lock needed during flush)
   std::vector<T> flushBuffer_;
 
-  //! The cache for stored select data
-  std::unordered_map<uint32_t, T> selectCache_;
+  //! The bounded cache of rows loaded through selectCacheById()
+  SelectCache<T> selectCache_;
+
+  //! Guards the select cache, which the update hook invalidates from the
+  //! writing thread
+  mutable std::mutex cacheMutex_;
+
+  //! Incremented whenever cached rows may have become stale
+  uint64_t cacheGeneration_;
+
+  //! Whether inserted rows are copied into the select cache
+  bool cacheWriteThrough_;
+
+  //! DAOs of tables that embed this table's rows
+  std::vector<DAOBase*> dependentCaches_;
 
   //! Mutex protecting the write buffer
   std::mutex bufferMutex_;
 
+  //! Number of rows in the write buffer, readable without the mutex
+  std::atomic<std::size_t> bufferedCount_;
+
+  //! Largest size the mutex-guarded write buffer has reached
+  std::atomic<std::size_t> highWaterMark_;
+
+  //! Capacity requested through reserveBuffer() for both buffer halves
+  std::size_t reservedCapacity_;
+
+  //! The lock-free write buffer, if that backend was selected
+  std::unique_ptr<MPSCRingBuffer<T>> pRingBuffer_;
+
+  //! Set once a row has been buffered, after which the backend is fixed
+  std::atomic<bool> bufferUsed_;
+
   //! The current ID counter for inserting new data
   uint32_t idCounter_;
 
+  //! Maximum rows written per flush transaction (0 means unlimited)
+  std::size_t maxRowsPerTransaction_;
+
+  //! Maximum rows bound to a single multi-row INSERT statement
+  std::size_t maxRowsPerInsert_;
+
+  //! Maximum parent IDs bound to a single junction SELECT statement
+  std::size_t maxIdsPerLookup_;
+
   //! Tracks whether or not the DAO is initialized
   bool isInitialized_;
 
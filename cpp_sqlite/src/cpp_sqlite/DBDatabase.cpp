@@ -1,4 +1,6 @@
 #include "cpp_sqlite/src/cpp_sqlite/DBDatabase.hpp"
+#include <filesystem>
+#include <fstream>
 #include <stdexcept>
 #include "cpp_sqlite/src/cpp_sqlite/DBDataAccessObject.hpp"
 
@@ -7,8 +9,33 @@ namespace cpp_sqlite
 
 Database::Database(std::string url,
                    bool allowWrite,
-                   std::shared_ptr<spdlog::logger> pLogger)
-  : db_(nullptr, sqlite3_close), pLogger_{pLogger}, daos_{}
+                   std::shared_ptr<spdlog::logger> pLogger,
+                   const DatabaseOptions& options)
+  : db_(nullptr, sqlite3_close),
+    pLogger_{pLogger},
+    daos_{},
+    daosMutex_{},
+    daoSegments_{},
+    daoSegmentStorage_{},
+    daosByTable_{},
+    tablesMutex_{},
+    transactionWrites_{},
+    pWriter_{nullptr},
+    pActor_{nullptr},
+    asyncExecutor_{},
+    connectionExecutor_{},
+    resumeExecutor_{},
+    pAsyncPool_{nullptr},
+    url_{url},
+    options_{options},
+    pReadPool_{nullptr},
+    transactionOwner_{},
+    pMetrics_{nullptr},
+    pActiveMetrics_{nullptr},
+    statementOrigins_{},
+    statementOriginsMutex_{},
+    pSlowQueries_{nullptr},
+    slowQueryLogEnabled_{false}
 {
   if (pLogger_)
   {
@@ -41,6 +68,104 @@ Database::Database(std::string url,
 
   // Transfer ownership to unique_ptr
   db_.reset(raw_db);
+
+  sqlite3_update_hook(db_.get(), &Database::onRowWritten, this);
+  sqlite3_rollback_hook(db_.get(), &Database::onRolledBack, this);
+
+  applyOptions(allowWrite);
+}
+
+Database::~Database()
+{
+  // Async work may still submit writes, so it finishes first
+  pAsyncPool_.reset();
+  stopBackgroundWriter();
+  stopWriteActor();
+}
+
+std::size_t Database::nextDAOSlot()
+{
+  static std::atomic<std::size_t> slotCounter{0};
+  return slotCounter.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Database::publishDAO(std::size_t slot, DAOBase& dao)
+{
+  const std::size_t segment = slot / kDAOSlotsPerSegment;
+  if (segment >= kDAOSegments)
+  {
+    // Still reachable through daos_, just not without the lock
+    return;
+  }
+
+  if (!daoSegmentStorage_[segment])
+  {
+    daoSegmentStorage_[segment] = std::make_unique<DAOSlotSegment>();
+    daoSegments_[segment].store(daoSegmentStorage_[segment].get(),
+                                std::memory_order_release);
+  }
+
+  daoSegmentStorage_[segment]->slots[slot % kDAOSlotsPerSegment].store(
+    &dao, std::memory_order_release);
+}
+
+void Database::onRowWritten(void* pDatabase,
+                            int operation,
+                            const char* /*dbName*/,
+                            const char* tableName,
+                            sqlite3_int64 rowId)
+{
+  auto& database = *static_cast<Database*>(pDatabase);
+
+  DAOBase* dao = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(database.tablesMutex_);
+    auto it = database.daosByTable_.find(std::string_view{tableName});
+    if (it == database.daosByTable_.end())
+    {
+      return;
+    }
+    dao = it->second;
+
+    // Remembered so that a rollback can drop what was cached meanwhile
+    if (sqlite3_get_autocommit(database.db_.get()) == 0 &&
+        std::ranges::find(database.transactionWrites_, dao) ==
+          database.transactionWrites_.end())
+    {
+      database.transactionWrites_.push_back(dao);
+    }
+  }
+
+  // The ID column is the rowid of every DAO table
+  dao->invalidateCachedRow(static_cast<uint32_t>(rowId),
+                           operation != SQLITE_INSERT);
+}
+
+void Database::onRolledBack(void* pDatabase)
+{
+  auto& database = *static_cast<Database*>(pDatabase);
+  database.clearTransactionCaches();
+  database.forgetTransactionWrites();
+}
+
+void Database::clearTransactionCaches()
+{
+  std::vector<DAOBase*> written;
+  {
+    std::lock_guard<std::mutex> lock(tablesMutex_);
+    written = transactionWrites_;
+  }
+
+  for (DAOBase* dao : written)
+  {
+    dao->clearCache();
+  }
+}
+
+void Database::forgetTransactionWrites()
+{
+  std::lock_guard<std::mutex> lock(tablesMutex_);
+  transactionWrites_.clear();
 }
 
 sqlite3& Database::getRawDB()
@@ -48,4 +173,626 @@ sqlite3& Database::getRawDB()
   return *db_;
 }
 
+FlushResult Database::flushAll()
+{
+  // Take a snapshot so that producers can keep registering DAOs while the
+  // flush is running. DAOs are never removed, so the pointers stay valid.
+  std::vector<DAOBase*> daos;
+  {
+    std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+    daos.reserve(daos_.size());
+    for (auto& [type, dao] : daos_)
+    {
+      daos.push_back(dao.get());
+    }
+  }
+
+  FlushResult combined{};
+  for (DAOBase* dao : daos)
+  {
+    FlushResult result = dao->insert();
+    combined.succeeded += result.succeeded;
+    combined.transactions += result.transactions;
+    combined.failedIds.insert(combined.failedIds.end(),
+                              result.failedIds.begin(),
+                              result.failedIds.end());
+
+    if (!result.ok())
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "Failed to flush {} rows of table {}",
+               result.failedIds.size(),
+               dao->getTableName());
+    }
+  }
+
+  return combined;
+}
+
+void Database::startBackgroundWriter(FlushPolicy policy)
+{
+  if (pWriter_)
+  {
+    LOG_SAFE(
+      pLogger_, spdlog::level::warn, "Background writer is already running");
+    return;
+  }
+
+  if (pActor_)
+  {
+    LOG_SAFE(pLogger_,
+             spdlog::level::err,
+             "Cannot start a background writer while a write actor owns the "
+             "connection");
+    return;
+  }
+
+  pWriter_ = std::make_unique<BackgroundWriter>(
+    [this] { flushAll(); },
+    [this]
+    {
+      std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+      std::size_t rows = 0;
+      for (const auto& [type, dao] : daos_)
+      {
+        rows += dao->bufferedCount();
+      }
+      return rows;
+    },
+    policy,
+    pLogger_);
+}
+
+void Database::stopBackgroundWriter()
+{
+  if (pWriter_)
+  {
+    pWriter_->stop();
+    pWriter_.reset();
+  }
+}
+
+bool Database::hasBackgroundWriter() const
+{
+  return pWriter_ != nullptr;
+}
+
+bool Database::startWriteActor(std::size_t maxCommandsPerTransaction)
+{
+  if (pActor_)
+  {
+    LOG_SAFE(pLogger_, spdlog::level::warn, "Write actor is already running");
+    return false;
+  }
+
+  if (pWriter_)
+  {
+    LOG_SAFE(pLogger_,
+             spdlog::level::err,
+             "Cannot start a write actor while a background writer owns the "
+             "connection");
+    return false;
+  }
+
+  pActor_ =
+    std::make_unique<WriteActor>(*this, maxCommandsPerTransaction, pLogger_);
+  return true;
+}
+
+void Database::stopWriteActor()
+{
+  if (pActor_)
+  {
+    pActor_->stop();
+    pActor_.reset();
+  }
+}
+
+bool Database::hasWriteActor() const
+{
+  return pActor_ != nullptr;
+}
+
+std::future<bool> Database::submitWrite(WriteActor::Command command)
+{
+  if (pActor_ && !pActor_->isActorThread())
+  {
+    return pActor_->submit(std::move(command));
+  }
+
+  std::promise<bool> done;
+  done.set_value(command());
+  return done.get_future();
+}
+
+void Database::setAsyncExecutor(Executor work, Executor resume)
+{
+  connectionExecutor_ =
+    work ? std::make_shared<Strand>(work)->executor() : Executor{};
+  asyncExecutor_ = std::move(work);
+  resumeExecutor_ = std::move(resume);
+}
+
+void Database::startAsyncExecutor(std::size_t threadCount, Executor resume)
+{
+  pAsyncPool_ = std::make_unique<ThreadPoolExecutor>(threadCount, pLogger_);
+  setAsyncExecutor(pAsyncPool_->executor(), std::move(resume));
+}
+
+AsyncResult<bool> Database::runAsyncWrite(WriteActor::Command command)
+{
+  if (!pActor_)
+  {
+    return runAsyncOn<bool>(connectionExecutor_, std::move(command));
+  }
+
+  return AsyncResult<bool>{
+    [this, command = std::move(command)](AsyncResult<bool>::Completion done)
+    { pActor_->submit(command, std::move(done)); },
+    resumeExecutor_};
+}
+
+void Database::flush()
+{
+  if (pWriter_)
+  {
+    pWriter_->requestFlush();
+  }
+  else if (pActor_)
+  {
+    submitWrite([this] { return flushAll().ok(); });
+  }
+  else
+  {
+    flushAll();
+  }
+}
+
+void Database::waitForDurable()
+{
+  if (pWriter_)
+  {
+    pWriter_->waitFor(pWriter_->requestFlush());
+  }
+  else if (pActor_)
+  {
+    submitWrite([this] { return flushAll().ok(); }).wait();
+  }
+  else
+  {
+    flushAll();
+  }
+}
+
+bool Database::openReadPool(std::size_t readerCount)
+{
+  if (pReadPool_)
+  {
+    LOG_SAFE(pLogger_, spdlog::level::warn, "Read pool is already open");
+    return false;
+  }
+
+  if (url_.empty() || url_ == ":memory:")
+  {
+    LOG_SAFE(pLogger_,
+             spdlog::level::err,
+             "A read pool needs a database file, not '{}'",
+             url_);
+    return false;
+  }
+
+  // journal_mode returns the mode that is in effect, which stays the
+  // rollback journal for read-only connections
+  const auto journalMode = queryPragma("journal_mode=WAL");
+  if (parseJournalMode(journalMode.value_or("")) != JournalMode::WAL)
+  {
+    LOG_SAFE(pLogger_,
+             spdlog::level::warn,
+             "Could not enable WAL mode (journal mode is '{}'); readers will "
+             "wait for writes to finish",
+             journalMode.value_or(""));
+  }
+
+  // Readers cannot change the journal mode, so they only take the rest
+  DatabaseOptions readerOptions = options_;
+  readerOptions.journalMode.reset();
+
+  try
+  {
+    pReadPool_ = std::make_unique<ReadPool>(
+      url_, readerCount, pLogger_, readerOptions);
+  }
+  catch (const std::runtime_error& error)
+  {
+    LOG_SAFE(pLogger_,
+             spdlog::level::err,
+             "Could not open read pool: {}",
+             error.what());
+    return false;
+  }
+
+  // Reads made by the readers count towards this database's metrics
+  std::shared_ptr<MetricsRegistry> pRegistry;
+  {
+    std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+    if (pActiveMetrics_)
+    {
+      pRegistry = pMetrics_;
+    }
+  }
+  if (pRegistry)
+  {
+    pReadPool_->attachMetrics(pRegistry);
+  }
+
+  std::shared_ptr<SlowQueryLog> pSlowQueries;
+  {
+    std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+    if (slowQueryLogEnabled_)
+    {
+      pSlowQueries = pSlowQueries_;
+    }
+  }
+  if (pSlowQueries)
+  {
+    pReadPool_->attachSlowQueryLog(pSlowQueries);
+  }
+
+  return true;
+}
+
+std::size_t Database::readerCount() const
+{
+  return pReadPool_ ? pReadPool_->size() : 0;
+}
+
+ReadLease Database::leaseReader()
+{
+  if (!pReadPool_ ||
+      transactionOwner_.load(std::memory_order_relaxed) ==
+        std::this_thread::get_id())
+  {
+    return {};
+  }
+
+  return pReadPool_->acquire();
+}
+
+DatabaseOptions Database::effectiveOptions()
+{
+  DatabaseOptions effective;
+
+  const auto integerPragma = [this](std::string_view pragma)
+  {
+    std::optional<int64_t> value;
+    if (auto text = queryPragma(pragma))
+    {
+      value = std::stoll(*text);
+    }
+    return value;
+  };
+
+  if (auto journalMode = queryPragma("journal_mode"))
+  {
+    effective.journalMode = parseJournalMode(*journalMode);
+  }
+  if (auto synchronous = integerPragma("synchronous"))
+  {
+    effective.synchronous = static_cast<SynchronousMode>(*synchronous);
+  }
+  if (auto tempStore = integerPragma("temp_store"))
+  {
+    effective.tempStore = static_cast<TempStore>(*tempStore);
+  }
+  effective.cacheSize = integerPragma("cache_size");
+  effective.mmapSize = integerPragma("mmap_size");
+  effective.pageSize = integerPragma("page_size");
+  effective.busyTimeoutMs = integerPragma("busy_timeout");
+  return effective;
+}
+
+void Database::enableMetrics(bool enabled)
+{
+  std::shared_ptr<MetricsRegistry> pRegistry;
+  if (enabled)
+  {
+    std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+    if (!pMetrics_)
+    {
+      pMetrics_ = std::make_shared<MetricsRegistry>();
+    }
+    pRegistry = pMetrics_;
+  }
+
+  attachMetrics(pRegistry);
+}
+
+bool Database::metricsEnabled() const
+{
+  std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+  return pActiveMetrics_ != nullptr;
+}
+
+MetricsSnapshot Database::metrics() const
+{
+  std::shared_ptr<MetricsRegistry> pRegistry;
+  {
+    std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+    pRegistry = pMetrics_;
+  }
+
+  return pRegistry ? pRegistry->snapshot() : MetricsSnapshot{};
+}
+
+bool Database::exportMetrics(const std::string& path) const
+{
+  const std::string tempPath = path + ".tmp";
+  {
+    std::ofstream file{tempPath, std::ios::trunc};
+    file << metrics().toPrometheus();
+    if (!file.good())
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "Could not write metrics to {}",
+               tempPath);
+      return false;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(tempPath, path, error);
+  if (error)
+  {
+    LOG_SAFE(pLogger_,
+             spdlog::level::err,
+             "Could not move metrics to {}: {}",
+             path,
+             error.message());
+    return false;
+  }
+  return true;
+}
+
+void Database::exportMetrics(
+  const std::function<void(std::string_view)>& sink) const
+{
+  sink(metrics().toPrometheus());
+}
+
+void Database::attachMetrics(const std::shared_ptr<MetricsRegistry>& pRegistry)
+{
+  {
+    std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+    if (pRegistry)
+    {
+      pMetrics_ = pRegistry;
+    }
+    pActiveMetrics_ = pRegistry.get();
+
+    for (auto& [type, dao] : daos_)
+    {
+      dao->attachMetrics(pActiveMetrics_);
+    }
+  }
+
+  if (pReadPool_)
+  {
+    pReadPool_->attachMetrics(pRegistry);
+  }
+}
+
+void Database::enableSlowQueryLog(std::chrono::nanoseconds threshold,
+                                  std::size_t capacity)
+{
+  std::shared_ptr<SlowQueryLog> pLog;
+  {
+    std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+    if (pSlowQueries_)
+    {
+      pSlowQueries_->configure(threshold, capacity);
+    }
+    else
+    {
+      pSlowQueries_ = std::make_shared<SlowQueryLog>(threshold, capacity);
+    }
+    pLog = pSlowQueries_;
+  }
+
+  attachSlowQueryLog(pLog);
+}
+
+void Database::disableSlowQueryLog()
+{
+  attachSlowQueryLog(nullptr);
+}
+
+std::vector<SlowQuery> Database::slowQueries() const
+{
+  std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+  return pSlowQueries_ ? pSlowQueries_->entries() : std::vector<SlowQuery>{};
+}
+
+std::string Database::dumpSlowQueries() const
+{
+  std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+  return pSlowQueries_ ? pSlowQueries_->dump() : std::string{};
+}
+
+void Database::registerStatement(const sqlite3_stmt* stmt,
+                                 std::string_view table,
+                                 std::string_view statement)
+{
+  std::lock_guard<std::mutex> lock(statementOriginsMutex_);
+  statementOrigins_[stmt] = StatementOrigin{table, statement};
+}
+
+void Database::attachSlowQueryLog(const std::shared_ptr<SlowQueryLog>& pLog)
+{
+  {
+    std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+
+    // The log is never replaced, since a callback may be using it
+    if (pLog && !pSlowQueries_)
+    {
+      pSlowQueries_ = pLog;
+    }
+    slowQueryLogEnabled_ = pLog != nullptr;
+
+    if (pLog)
+    {
+      sqlite3_trace_v2(
+        db_.get(), SQLITE_TRACE_PROFILE, &Database::onStatementTraced, this);
+    }
+    else
+    {
+      sqlite3_trace_v2(db_.get(), 0, nullptr, nullptr);
+    }
+  }
+
+  if (pReadPool_)
+  {
+    pReadPool_->attachSlowQueryLog(pLog);
+  }
+}
+
+int Database::onStatementTraced(unsigned type,
+                                void* pDatabase,
+                                void* pStmt,
+                                void* pNanos)
+{
+  if (type != SQLITE_TRACE_PROFILE)
+  {
+    return 0;
+  }
+
+  auto& database = *static_cast<Database*>(pDatabase);
+  const sqlite3_int64 nanos = *static_cast<const sqlite3_int64*>(pNanos);
+  if (!database.pSlowQueries_->isSlow(nanos))
+  {
+    return 0;
+  }
+
+  auto* stmt = static_cast<sqlite3_stmt*>(pStmt);
+
+  SlowQuery query{};
+  query.duration = std::chrono::nanoseconds{nanos};
+  if (char* expanded = sqlite3_expanded_sql(stmt))
+  {
+    query.sql = expanded;
+    sqlite3_free(expanded);
+  }
+  else if (const char* sql = sqlite3_sql(stmt))
+  {
+    query.sql = sql;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(database.statementOriginsMutex_);
+    auto it = database.statementOrigins_.find(stmt);
+    if (it != database.statementOrigins_.end())
+    {
+      query.table = it->second.table;
+      query.statement = it->second.statement;
+    }
+  }
+
+  database.pSlowQueries_->record(std::move(query));
+  return 0;
+}
+
+void Database::applyOptions(bool allowWrite)
+{
+  if (options_.busyTimeoutMs)
+  {
+    sqlite3_busy_timeout(db_.get(), static_cast<int>(*options_.busyTimeoutMs));
+  }
+
+  // The page size has to be set before the database is switched to WAL
+  if (options_.pageSize && allowWrite)
+  {
+    queryPragma("page_size=" + std::to_string(*options_.pageSize));
+  }
+
+  if (options_.journalMode && allowWrite)
+  {
+    const auto journalMode = queryPragma(
+      "journal_mode=" + std::string{toPragmaValue(*options_.journalMode)});
+    if (parseJournalMode(journalMode.value_or("")) != options_.journalMode)
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::warn,
+               "Requested journal mode {} for {}, but SQLite uses '{}'",
+               toPragmaValue(*options_.journalMode),
+               url_,
+               journalMode.value_or(""));
+    }
+  }
+
+  if (options_.synchronous)
+  {
+    queryPragma("synchronous=" +
+                std::to_string(static_cast<int>(*options_.synchronous)));
+  }
+  if (options_.cacheSize)
+  {
+    queryPragma("cache_size=" + std::to_string(*options_.cacheSize));
+  }
+  if (options_.mmapSize)
+  {
+    queryPragma("mmap_size=" + std::to_string(*options_.mmapSize));
+  }
+  if (options_.tempStore)
+  {
+    queryPragma("temp_store=" +
+                std::to_string(static_cast<int>(*options_.tempStore)));
+  }
+
+  LOG_SAFE(pLogger_,
+           spdlog::level::debug,
+           "Opened {} with {}",
+           url_,
+           effectiveOptions().toString());
+}
+
+std::optional<std::string> Database::queryPragma(std::string_view pragma)
+{
+  const std::string sql = "PRAGMA " + std::string{pragma} + ";";
+
+  std::optional<std::string> value;
+  char* errMsg = nullptr;
+  int result = sqlite3_exec(
+    db_.get(),
+    sql.c_str(),
+    [](void* pValue, int, char** values, char**)
+    {
+      auto& firstValue = *static_cast<std::optional<std::string>*>(pValue);
+      if (!firstValue && values[0])
+      {
+        firstValue = values[0];
+      }
+      return 0;
+    },
+    &value,
+    &errMsg);
+
+  if (result != SQLITE_OK)
+  {
+    LOG_SAFE(pLogger_,
+             spdlog::level::warn,
+             "'{}' failed with code {}: {}",
+             sql,
+             result,
+             errMsg ? errMsg : "unknown error");
+  }
+  sqlite3_free(errMsg);
+  return value;
+}
+
+void Database::setTransactionOwner(std::thread::id owner)
+{
+  transactionOwner_.store(owner, std::memory_order_relaxed);
+}
+
 }  // namespace cpp_sqlite
\ No newline at end of file
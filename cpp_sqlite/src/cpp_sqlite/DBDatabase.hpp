@@ -2,9 +2,22 @@
 #ifndef DB_DATABASE_HPP
 #define DB_DATABASE_HPP
 
+#include <algorithm>
 #include <any>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <typeindex>
 #include <unordered_map>
 #include <vector>
@@ -13,15 +26,20 @@
 #include <boost/mp11.hpp>
 #include <boost/unordered_map.hpp>
 
-#include <boost/type_index.hpp>
 #include "sqlite3.h"
 
+#include "cpp_sqlite/src/cpp_sqlite/DBAsync.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBBackgroundWriter.hpp"
 #include "cpp_sqlite/src/cpp_sqlite/DBBaseTransferObject.hpp"
 #include "cpp_sqlite/src/cpp_sqlite/DBDAOBase.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBDatabaseOptions.hpp"
 #include "cpp_sqlite/src/cpp_sqlite/DBForeignKey.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBMetrics.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBReadPool.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBSlowQueryLog.hpp"
 #include "cpp_sqlite/src/cpp_sqlite/DBTraits.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBWriteActor.hpp"
 #include "cpp_sqlite/src/utils/Logger.hpp"
-#include "cpp_sqlite/src/utils/StringUtils.hpp"
 
 namespace cpp_sqlite
 {
@@ -34,6 +52,9 @@ class DataAccessObject;
 class Database
 {
 public:
+  //! Default number of statements kept by the slow query log
+  static constexpr std::size_t kDefaultSlowQueryCapacity = 128;
+
   /*!
    * \brief Create a SQLite database with a given
    *        url and specify whether we allow read
@@ -42,191 +63,346 @@ public:
    *        sqlite constructor
    * \param allowWrite The boolean indicating
    *        whether this is a read-only database.
+   * \param options The PRAGMA settings applied after opening, for example
+   *        DatabaseOptions::fastIngest()
    */
   Database(std::string url,
            bool allowWrite,
-           std::shared_ptr<spdlog::logger> pLogger = nullptr);
+           std::shared_ptr<spdlog::logger> pLogger = nullptr,
+           const DatabaseOptions& options = {});
+
+  /*!
+   * \brief Stop the background writer (flushing any buffered rows) and
+   *        close the database
+   */
+  ~Database();
 
   /*!
    * \brief Get or create a DAO for the specified type
+   *
+   * Safe to call from any thread. Once the DAO exists, the lookup is two
+   * atomic loads indexed by a slot number assigned to T on first use, so
+   * it takes no lock. Creating a DAO is serialized.
    */
   template <ValidTransferObject T>
   DataAccessObject<T>& getDAO()
   {
-    auto typeIdx = std::type_index(typeid(T));
-    auto it = daos_.find(typeIdx);
-
-    if (it == daos_.end())
+    const std::size_t slot = daoSlot<T>();
+    if (DAOBase* dao = findDAO(slot))
     {
-      auto dao = std::make_unique<DataAccessObject<T>>(*this, pLogger_);
-      auto& daoRef = *dao;
-      daos_.emplace(typeIdx, std::move(dao));
-      return daoRef;
+      // Safe static_cast - the slot is unique to T
+      return static_cast<DataAccessObject<T>&>(*dao);
     }
 
-    // Safe static_cast - we know the type from the map key
-    return static_cast<DataAccessObject<T>&>(*it->second);
+    return createDAO<T>(slot);
   }
 
   /*!
    * \brief Perform a generic SELECT operation
+   *
+   * The rows of the statement are decoded first. Repeated fields are then
+   * loaded for the whole result set at once by loadRepeatedFields().
+   *
+   * \param stmt The SELECT statement, with its parameters bound
+   * \param pMetrics Records the execution, excluding the loading of
+   *        repeated fields, if set
    * \return Vector of objects matching the query
    */
   template <ValidTransferObject T>
-  std::vector<T> select(PreparedSQLStmt& stmt)
+  std::vector<T> select(PreparedSQLStmt& stmt,
+                        StatementMetrics* pMetrics = nullptr)
   {
     std::vector<T> results;
 
-    // Execute the query and iterate through results
-    while (sqlite3_step(stmt.get()) == SQLITE_ROW)
     {
-      T obj;
-      int columnIndex = 0;
-
-      // Process public members to read column values
-      boost::mp11::mp_for_each<boost::describe::describe_members<
-        T,
-        boost::describe::mod_inherited | boost::describe::mod_public>>(
-        [&](auto D)
+      StatementTimer timer{pMetrics};
+
+      // Execute the query and iterate through results
+      while (sqlite3_step(stmt.get()) == SQLITE_ROW)
+      {
+        T obj;
+        int columnIndex = 0;
+        readColumns(stmt.get(), obj, columnIndex);
+        results.push_back(std::move(obj));
+      }
+
+      // Reset the statement for potential reuse
+      sqlite3_reset(stmt.get());
+      timer.addRows(results.size());
+    }
+
+    loadRepeatedFields<T>(results);
+
+    return results;
+  }
+
+  /*!
+   * \brief Decode the columns of the current row of a statement into an
+   *        object
+   *
+   * Nested transfer objects are read from the columns that follow their
+   * `_id` column, as laid out by detail::appendSelectSource().
+   * Repeated fields have no column and are left untouched.
+   *
+   * \param stmt The statement positioned on a row
+   * \param obj The object that receives the column values
+   * \param columnIndex The column holding the first member of T. Advanced
+   *        past the columns of T.
+   */
+  template <ValidTransferObject T>
+  void readColumns(sqlite3_stmt* stmt, T& obj, int& columnIndex)
+  {
+    // Process public members to read column values
+    boost::mp11::mp_for_each<boost::describe::describe_members<
+      T,
+      boost::describe::mod_inherited | boost::describe::mod_public>>(
+      [&](auto D)
+      {
+        using memberType = std::remove_cv_t<
+          std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+
+        // Handle ForeignKey - just read the ID, don't load the object
+        if constexpr (IsForeignKey<memberType>)
         {
-          using memberType = std::remove_cv_t<
-            std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+          auto& fk = obj.*D.pointer;
+          fk.id =
+            static_cast<uint32_t>(sqlite3_column_int64(stmt, columnIndex));
+          columnIndex++;
+        }
+        // Repeated fields live in junction tables and are loaded
+        // separately
+        else if constexpr (IsRepeatedFieldTransferObject<memberType>)
+        {
+        }
+        else if constexpr (ValidTransferObject<memberType>)
+        {
+          // For nested transfer objects, the joined row follows the
+          // foreign key ID column
+          auto& nestedObj = obj.*D.pointer;
+          uint32_t nestedId =
+            static_cast<uint32_t>(sqlite3_column_int64(stmt, columnIndex));
+          columnIndex++;
 
-          // Handle ForeignKey - just read the ID, don't load the object
-          if constexpr (IsForeignKey<memberType>)
+          // The LEFT JOIN yields NULL columns if the nested row is missing
+          if (sqlite3_column_type(stmt, columnIndex) != SQLITE_NULL)
           {
-            auto& fk = obj.*D.pointer;
-            fk.id = static_cast<uint32_t>(
-              sqlite3_column_int64(stmt.get(), columnIndex));
-            columnIndex++;
+            readColumns(stmt, nestedObj, columnIndex);
           }
-          // Handle repeated field transfer objects (junction tables)
-          else if constexpr (IsRepeatedFieldTransferObject<memberType>)
+          else
           {
-            // Load repeated fields from junction table
-            auto& repeatedFieldObj = obj.*D.pointer;
-            using fieldType = RepeatedFieldOfType<memberType>;
-
-            // Build the query to get related IDs from junction table
-            auto memberName = getDAO<T>().getTableName();
-            const std::string dataName = stripNamespace(
-              boost::typeindex::type_id<fieldType>().pretty_name());
-            std::string junctionQuery = "SELECT " + dataName + "_id FROM " +
-                                        memberName + "_" + dataName +
-                                        " WHERE " + memberName + "_id = ?;";
+            // If not found, just set the ID
+            nestedObj.id = nestedId;
+            columnIndex += static_cast<int>(selectColumnCount<memberType>());
+          }
+        }
+        else if constexpr (isIntegral<memberType>)
+        {
+          obj.*D.pointer =
+            static_cast<memberType>(sqlite3_column_int64(stmt, columnIndex));
+          columnIndex++;
+        }
+        else if constexpr (floatingPoint<memberType>)
+        {
+          obj.*D.pointer =
+            static_cast<memberType>(sqlite3_column_double(stmt, columnIndex));
+          columnIndex++;
+        }
+        else if constexpr (isString<memberType>)
+        {
+          const unsigned char* text = sqlite3_column_text(stmt, columnIndex);
+          if (text)
+          {
+            obj.*D.pointer = std::string(reinterpret_cast<const char*>(text));
+          }
+          columnIndex++;
+        }
+        else if constexpr (isBlob<memberType>)
+        {
+          const void* blobData = sqlite3_column_blob(stmt, columnIndex);
+          int blobSize = sqlite3_column_bytes(stmt, columnIndex);
 
-            LOG_SAFE(pLogger_,
-                     spdlog::level::debug,
-                     "Junction query: {}",
-                     junctionQuery);
+          if (blobData && blobSize > 0)
+          {
+            const uint8_t* data = static_cast<const uint8_t*>(blobData);
+            obj.*D.pointer = std::vector<uint8_t>(data, data + blobSize);
+          }
+          columnIndex++;
+        }
+      });
+  }
 
-            // Prepare and execute junction table query
-            sqlite3_stmt* rawPtr = nullptr;
-            int result = sqlite3_prepare_v2(
-              db_.get(), junctionQuery.c_str(), -1, &rawPtr, nullptr);
+  /*!
+   * \brief Load the repeated fields of a set of parent rows
+   *
+   * Instead of one junction query plus one SELECT per child for every
+   * parent, the children of all parents are read with a few batched
+   * statements that join the junction table to the child table. The
+   * children are then grouped back into their parents. Repeated fields of
+   * nested transfer objects are loaded the same way.
+   *
+   * \param parents The parent rows, whose repeated fields are empty
+   */
+  template <ValidTransferObject T>
+  void loadRepeatedFields(std::span<T> parents)
+  {
+    if constexpr (hasRepeatedFields<T>())
+    {
+      std::vector<T*> parentPtrs;
+      parentPtrs.reserve(parents.size());
+      for (T& parent : parents)
+      {
+        parentPtrs.push_back(&parent);
+      }
+      loadRepeatedFields<T>(std::span<T* const>{parentPtrs});
+    }
+  }
 
-            if (result == SQLITE_OK)
-            {
-              // Bind the parent object's ID
-              sqlite3_bind_int64(rawPtr, 1, static_cast<sqlite3_int64>(obj.id));
+  /*!
+   * \brief Load the repeated fields of a set of parent rows that are not
+   *        stored contiguously
+   * \param parents The parent rows, whose repeated fields are empty
+   */
+  template <ValidTransferObject T>
+  void loadRepeatedFields(std::span<T* const> parents)
+  {
+    if (parents.empty())
+    {
+      return;
+    }
 
-              // Collect all child IDs
-              std::vector<uint32_t> childIds;
-              while (sqlite3_step(rawPtr) == SQLITE_ROW)
-              {
-                childIds.push_back(
-                  static_cast<uint32_t>(sqlite3_column_int64(rawPtr, 0)));
-              }
+    // Built on first use, since most types have no repeated fields. Rows
+    // that embed the same nested object each hold their own copy of it,
+    // so one id can map to several parents.
+    std::unordered_map<uint32_t, std::vector<T*>> parentsById;
+    std::vector<T*> uniqueParents;
 
-              // Load each child object by ID
-              auto& childDAO = getDAO<fieldType>();
-              for (uint32_t childId : childIds)
-              {
-                auto childObj = childDAO.selectById(childId);
-                if (childObj.has_value())
-                {
-                  repeatedFieldObj.data.push_back(std::move(childObj.value()));
-                }
-              }
-            }
+    boost::mp11::mp_for_each<boost::describe::describe_members<
+      T,
+      boost::describe::mod_inherited | boost::describe::mod_public>>(
+      [&](auto D)
+      {
+        using memberType = std::remove_cv_t<
+          std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
 
-            sqlite3_finalize(rawPtr);
-          }
-          else if constexpr (ValidTransferObject<memberType>)
+        if constexpr (IsRepeatedFieldTransferObject<memberType>)
+        {
+          using fieldType = RepeatedFieldOfType<memberType>;
+
+          auto& parentDAO = getDAO<T>();
+
+          // Make sure the child table exists before the join is prepared
+          getDAO<fieldType>();
+
+          if (parentsById.empty())
           {
-            // For nested transfer objects, recursively load the object
-            auto& nestedObj = obj.*D.pointer;
-            if constexpr (isIntegral<decltype(nestedObj.id)>)
+            parentsById.reserve(parents.size());
+            uniqueParents.reserve(parents.size());
+            for (T* parent : parents)
             {
-              // Read the foreign key ID from the column
-              uint32_t nestedId = static_cast<uint32_t>(
-                sqlite3_column_int64(stmt.get(), columnIndex));
-
-              // Recursively load the nested object by ID
-              auto& nestedDAO = getDAO<memberType>();
-              auto loadedObj = nestedDAO.selectById(nestedId);
-              if (loadedObj.has_value())
+              auto& sameId = parentsById[parent->id];
+              if (sameId.empty())
               {
-                nestedObj = std::move(loadedObj.value());
-              }
-              else
-              {
-                // If not found, just set the ID
-                nestedObj.id = nestedId;
+                uniqueParents.push_back(parent);
               }
+              sameId.push_back(parent);
             }
-            columnIndex++;
           }
-          else if constexpr (isIntegral<memberType>)
-          {
-            obj.*D.pointer = static_cast<memberType>(
-              sqlite3_column_int64(stmt.get(), columnIndex));
-            columnIndex++;
-          }
-          else if constexpr (floatingPoint<memberType>)
-          {
-            obj.*D.pointer = static_cast<memberType>(
-              sqlite3_column_double(stmt.get(), columnIndex));
-            columnIndex++;
-          }
-          else if constexpr (isString<memberType>)
+
+          std::vector<fieldType> children;
+          std::vector<uint32_t> childParentIds;
+
+          StatementMetrics* pLookupMetrics =
+            parentDAO.template getJunctionMetrics<fieldType>(
+              StatementKind::JunctionSelect);
+
+          std::span<T* const> remaining{uniqueParents};
+          while (!remaining.empty())
           {
-            const unsigned char* text =
-              sqlite3_column_text(stmt.get(), columnIndex);
-            if (text)
+            std::size_t count = std::bit_floor(
+              std::min(remaining.size(), parentDAO.getMaxIdsPerLookup()));
+            auto chunk = remaining.first(count);
+            remaining = remaining.subspan(count);
+
+            PreparedSQLStmt* lookupStmt =
+              parentDAO.template getJunctionSelectStatement<fieldType>(count);
+            if (!lookupStmt)
             {
-              obj.*D.pointer = std::string(reinterpret_cast<const char*>(text));
+              continue;
+            }
+
+            sqlite3_stmt* rawPtr = lookupStmt->get();
+            sqlite3_reset(rawPtr);
+
+            int paramIndex = 1;
+            for (const T* parent : chunk)
+            {
+              sqlite3_bind_int64(
+                rawPtr, paramIndex++, static_cast<sqlite3_int64>(parent->id));
             }
-            columnIndex++;
-          }
-          else if constexpr (isBlob<memberType>)
-          {
-            const void* blobData = sqlite3_column_blob(stmt.get(), columnIndex);
-            int blobSize = sqlite3_column_bytes(stmt.get(), columnIndex);
 
-            if (blobData && blobSize > 0)
+            StatementTimer timer{pLookupMetrics};
+            const std::size_t firstChild = children.size();
+            while (sqlite3_step(rawPtr) == SQLITE_ROW)
             {
-              const uint8_t* data = static_cast<const uint8_t*>(blobData);
-              obj.*D.pointer = std::vector<uint8_t>(data, data + blobSize);
+              childParentIds.push_back(
+                static_cast<uint32_t>(sqlite3_column_int64(rawPtr, 0)));
+              fieldType child;
+              int columnIndex = 1;
+              readColumns(rawPtr, child, columnIndex);
+              children.push_back(std::move(child));
             }
-            columnIndex++;
+            sqlite3_reset(rawPtr);
+            timer.addRows(children.size() - firstChild);
           }
-        });
 
-      results.push_back(std::move(obj));
-    }
+          // The children may have repeated fields of their own
+          loadRepeatedFields<fieldType>(children);
 
-    // Reset the statement for potential reuse
-    sqlite3_reset(stmt.get());
+          for (std::size_t i = 0; i < children.size(); ++i)
+          {
+            auto parentIt = parentsById.find(childParentIds[i]);
+            if (parentIt == parentsById.end())
+            {
+              continue;
+            }
 
-    return results;
+            // Copy to every parent with this id, then move into the last
+            const std::vector<T*>& sameId = parentIt->second;
+            for (std::size_t j = 0; j + 1 < sameId.size(); ++j)
+            {
+              (sameId[j]->*D.pointer).data.push_back(children[i]);
+            }
+            (sameId.back()->*D.pointer).data.push_back(std::move(children[i]));
+          }
+        }
+        else if constexpr (ValidTransferObject<memberType>)
+        {
+          if constexpr (hasRepeatedFields<memberType>())
+          {
+            std::vector<memberType*> nestedObjs;
+            nestedObjs.reserve(parents.size());
+            for (T* parent : parents)
+            {
+              nestedObjs.push_back(&(parent->*D.pointer));
+            }
+            loadRepeatedFields<memberType>(
+              std::span<memberType* const>{nestedObjs});
+          }
+        }
+      });
   }
 
   /*!
    * \brief Perform a generic insert operation
+   * \param stmt The insert statement
+   * \param data The row to insert
+   * \param pMetrics Records the execution, excluding the inserts of nested
+   *        objects and repeated fields, if set
    */
   template <ValidTransferObject T>
-  bool insert(PreparedSQLStmt& stmt, T& data)
+  bool insert(PreparedSQLStmt& stmt,
+              T& data,
+              StatementMetrics* pMetrics = nullptr)
   {
     // Reset the statement for reuse
     sqlite3_reset(stmt.get());
@@ -234,6 +410,79 @@ public:
     // Track parameter index (SQLite uses 1-based indexing)
     int paramIndex = 1;
 
+    bindInsertParameters(stmt, data, paramIndex);
+
+    // Execute the statement
+    StatementTimer timer{pMetrics};
+    int result = sqlite3_step(stmt.get());
+
+    if (result != SQLITE_DONE)
+    {
+      LOG_SAFE(
+        pLogger_, spdlog::level::err, "Insert failed with code: {}", result);
+      return false;
+    }
+
+    timer.addRows(1);
+    return true;
+  }
+
+  /*!
+   * \brief Insert several rows with a single multi-row INSERT statement
+   *
+   * The statement must have been prepared with one VALUES group per row.
+   * A single statement is atomic, so on failure none of the rows are
+   * written.
+   *
+   * \param stmt The multi-row insert statement
+   * \param rows The rows to bind, in the order of the VALUES groups
+   * \param pMetrics Records the execution, if set
+   * \return True if all rows were inserted
+   */
+  template <FlatTransferObject T>
+  bool insertMany(PreparedSQLStmt& stmt,
+                  std::span<T* const> rows,
+                  StatementMetrics* pMetrics = nullptr)
+  {
+    sqlite3_reset(stmt.get());
+
+    int paramIndex = 1;
+    for (T* row : rows)
+    {
+      bindInsertParameters(stmt, *row, paramIndex);
+    }
+
+    StatementTimer timer{pMetrics};
+    int result = sqlite3_step(stmt.get());
+
+    if (result != SQLITE_DONE)
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::debug,
+               "Multi-row insert of {} rows failed with code: {}",
+               rows.size(),
+               result);
+      return false;
+    }
+
+    timer.addRows(rows.size());
+    return true;
+  }
+
+  /*!
+   * \brief Bind the column values of one row to an insert statement
+   *
+   * Nested transfer objects and repeated fields are inserted into their
+   * own tables as a side effect, before their IDs are bound.
+   *
+   * \param stmt The insert statement
+   * \param data The row to bind
+   * \param paramIndex The first parameter index to bind. Advanced past the
+   *        parameters of this row.
+   */
+  template <ValidTransferObject T>
+  void bindInsertParameters(PreparedSQLStmt& stmt, T& data, int& paramIndex)
+  {
     // Process public members
     boost::mp11::mp_for_each<boost::describe::describe_members<
       T,
@@ -274,21 +523,23 @@ public:
           auto& repeatedFieldObj = data.*D.pointer;
           using fieldType = RepeatedFieldOfType<memberType>;
 
-          auto memberName = getDAO<T>().getTableName();
-          const std::string dataName = stripNamespace(
-            boost::typeindex::type_id<fieldType>().pretty_name());
-          std::string mapTable = "INSERT INTO " + memberName + "_" + dataName +
-                                 "(" + memberName + "_id, " + dataName +
-                                 "_id) VALUES (?, ?);";
-
-          sqlite3_stmt* rawPtr = nullptr;
-          sqlite3_prepare_v2(db_.get(), mapTable.c_str(), -1, &rawPtr, nullptr);
-
+          auto& parentDAO = getDAO<T>();
+          PreparedSQLStmt* junctionStmt =
+            parentDAO.template getJunctionInsertStatement<fieldType>();
+          StatementMetrics* pJunctionMetrics =
+            parentDAO.template getJunctionMetrics<fieldType>(
+              StatementKind::JunctionInsert);
 
           for (auto& repeatedFieldData : repeatedFieldObj.data)
           {
             getDAO<fieldType>().insert(repeatedFieldData);
 
+            if (!junctionStmt)
+            {
+              continue;
+            }
+
+            sqlite3_stmt* rawPtr = junctionStmt->get();
 
             LOG_SAFE(pLogger_,
                      spdlog::level::debug,
@@ -296,11 +547,13 @@ public:
                      data.id,
                      repeatedFieldData.id);
 
+            sqlite3_reset(rawPtr);
             sqlite3_bind_int64(rawPtr, 1, static_cast<sqlite3_int64>(data.id));
             sqlite3_bind_int64(
               rawPtr, 2, static_cast<sqlite3_int64>(repeatedFieldData.id));
 
             // Execute the statement
+            StatementTimer timer{pJunctionMetrics};
             int result = sqlite3_step(rawPtr);
 
             if (result != SQLITE_DONE)
@@ -310,11 +563,14 @@ public:
                        "Insert failed with code: {}",
                        result);
             }
+            else
+            {
+              timer.addRows(1);
+            }
 
             // Reset the statement for reuse
             sqlite3_reset(rawPtr);
           }
-          sqlite3_finalize(rawPtr);
           // do nothing - paramIndex stays the same as repeated fields don't add
           // columns to parent table
         }
@@ -360,26 +616,525 @@ public:
           }
         }
       });
+  }
 
-    // Execute the statement
-    int result = sqlite3_step(stmt.get());
+  /*!
+   * \brief Get raw SQLite database pointer for direct access
+   * \return Raw sqlite3* pointer
+   */
+  sqlite3& getRawDB();
 
-    if (result != SQLITE_DONE)
+  /*!
+   * \brief Flush the write buffers of every registered DAO on the calling
+   *        thread
+   * \return The combined result of all DAO flushes
+   */
+  FlushResult flushAll();
+
+  /*!
+   * \brief Start a background thread that flushes the DAO write buffers
+   *        according to the given policy
+   *
+   * While the writer runs, rows should be written through the DAO buffers
+   * (addToBuffer) rather than by calling insert() directly, since the
+   * writer owns the flush side of every buffer.
+   *
+   * \param policy When to flush
+   */
+  void startBackgroundWriter(FlushPolicy policy = {});
+
+  /*!
+   * \brief Stop the background writer after a final flush
+   */
+  void stopBackgroundWriter();
+
+  /*!
+   * \brief Check whether a background writer is running
+   */
+  bool hasBackgroundWriter() const;
+
+  /*!
+   * \brief Start a write actor that owns all writes to this connection
+   *
+   * Afterwards, write commands submitted with submitWrite() (and DAO
+   * insertAsync() calls) from any thread run on the actor thread, batched
+   * into transactions. flush() and waitForDurable() flush the DAO buffers
+   * on the actor as well. Cannot be combined with a background writer.
+   *
+   * \param maxCommandsPerTransaction The most commands run in one
+   *        transaction
+   * \return True if the actor was started
+   */
+  bool startWriteActor(std::size_t maxCommandsPerTransaction = 1024);
+
+  /*!
+   * \brief Stop the write actor after running every queued command
+   */
+  void stopWriteActor();
+
+  /*!
+   * \brief Check whether a write actor is running
+   */
+  bool hasWriteActor() const;
+
+  /*!
+   * \brief Run a write command on the write actor
+   *
+   * Without a write actor, or when called from the actor thread itself,
+   * the command runs immediately on the calling thread.
+   *
+   * \param command Writes to this database and returns true on success
+   * \return A future that becomes true once the command's writes are
+   *         committed
+   */
+  std::future<bool> submitWrite(WriteActor::Command command);
+
+  /*!
+   * \brief Run the awaitable DAO operations on the given executor
+   *
+   * Reads run on the executor, on a pooled reader if a read pool is open.
+   * Writes run on the write actor if one is running, otherwise on the
+   * executor. Work that uses this connection itself (reads without a read
+   * pool, writes without a write actor) is serialized on a Strand, since
+   * the DAOs' prepared statements must not be used from two threads at
+   * once; the executor may have any number of threads. Must be set before
+   * any operation is awaited.
+   *
+   * \param work Runs the database work
+   * \param resume Resumes awaiting coroutines, for example by posting to
+   *        their event loop. Empty to resume on the thread that completed
+   *        the work.
+   */
+  void setAsyncExecutor(Executor work, Executor resume = {});
+
+  /*!
+   * \brief Run the awaitable DAO operations on threads owned by this
+   *        database
+   * \param threadCount The number of worker threads
+   * \param resume Resumes awaiting coroutines (see setAsyncExecutor())
+   */
+  void startAsyncExecutor(std::size_t threadCount = 1, Executor resume = {});
+
+  /*!
+   * \brief Run a read on the async executor
+   *
+   * Without an async executor the work runs immediately and the returned
+   * awaitable is already complete. Without a read pool the work runs on
+   * this connection, so it is serialized with the other work that does.
+   * If the work throws, awaiting the result rethrows the exception.
+   *
+   * \param work The work to run
+   * \return An awaitable that yields the result of the work
+   */
+  template <typename R>
+  AsyncResult<R> runAsync(std::function<R()> work)
+  {
+    return runAsyncOn<R>(pReadPool_ ? asyncExecutor_ : connectionExecutor_,
+                         std::move(work));
+  }
+
+  /*!
+   * \brief Run a write command on the write actor, or on the async
+   *        executor if there is no actor
+   * \return An awaitable that yields true once the writes are committed
+   */
+  AsyncResult<bool> runAsyncWrite(WriteActor::Command command);
+
+  /*!
+   * \brief Request a flush of all DAO buffers
+   *
+   * With a background writer or a write actor this only wakes that thread
+   * and returns immediately. Otherwise, the buffers are flushed on the
+   * calling thread.
+   */
+  void flush();
+
+  /*!
+   * \brief Block until every row buffered before this call is committed
+   */
+  void waitForDurable();
+
+  /*!
+   * \brief Open a pool of read-only connections to the database file
+   *
+   * Switches this (writer) connection to WAL mode so that readers do not
+   * block on writes. Afterwards the DAO read calls (selectAll, selectById,
+   * selectByIds and the cache lookups built on them) run on a free reader
+   * instead of the writer connection, unless the calling thread has a
+   * Transaction open on this database. Cursors keep using the writer
+   * connection.
+   *
+   * Must be called before other threads start using the database. Rows
+   * read through a reader see the last committed state, so rows that are
+   * still in a DAO write buffer are not visible.
+   *
+   * \param readerCount The number of read connections
+   * \return True if the pool was opened
+   */
+  bool openReadPool(std::size_t readerCount);
+
+  /*!
+   * \brief Get the number of pooled read connections (zero without a pool)
+   */
+  std::size_t readerCount() const;
+
+  /*!
+   * \brief Lease a read connection for a read made through this database
+   * \return A free reader, or an empty lease if reads should run on this
+   *         connection
+   */
+  ReadLease leaseReader();
+
+  /*!
+   * \brief Read back the settings that are in effect on this connection
+   *
+   * SQLite silently ignores some requests, for example WAL mode for an
+   * in-memory database or a new page size for an existing file, so these
+   * can differ from the options the database was opened with.
+   *
+   * \return Every setting that SQLite reports
+   */
+  DatabaseOptions effectiveOptions();
+
+  /*!
+   * \brief Start or stop recording per-statement metrics
+   *
+   * While enabled, every execution of a DAO's INSERT, SELECT and junction
+   * table statements is counted and timed, on this connection and on the
+   * connections of its read pool. Metrics are kept when recording stops
+   * and continue when it is enabled again. Disabled by default, in which
+   * case no clock is read. Building with CPP_SQLITE_METRICS=OFF compiles
+   * the recording out altogether.
+   *
+   * \param enabled Whether to record metrics
+   */
+  void enableMetrics(bool enabled = true);
+
+  /*!
+   * \brief Check whether per-statement metrics are being recorded
+   */
+  bool metricsEnabled() const;
+
+  /*!
+   * \brief Get the metrics recorded so far
+   * \return The metrics of every statement that was executed while
+   *         recording, or an empty snapshot if metrics were never enabled
+   */
+  MetricsSnapshot metrics() const;
+
+  /*!
+   * \brief Write the metrics in the Prometheus text format to a file
+   *
+   * The file is written next to its destination and then renamed, so a
+   * collector such as the node exporter's textfile collector never reads
+   * a partial file.
+   *
+   * \param path The file to write
+   * \return True if the file was written
+   */
+  bool exportMetrics(const std::string& path) const;
+
+  /*!
+   * \brief Pass the metrics in the Prometheus text format to a callback,
+   *        for example one that serves a scrape endpoint
+   */
+  void exportMetrics(const std::function<void(std::string_view)>& sink) const;
+
+  /*!
+   * \brief Capture the statements that run longer than a threshold
+   *
+   * Registers an SQLITE_TRACE_PROFILE callback (sqlite3_trace_v2) on this
+   * connection and on the connections of its read pool. Every statement
+   * that runs for at least the threshold is kept in a bounded ring with
+   * its expanded SQL, its duration and the DAO table it belongs to; once
+   * the ring is full, new entries replace the oldest. Calling this again
+   * changes the threshold and the capacity and keeps the entries.
+   *
+   * \param threshold The shortest duration that is captured
+   * \param capacity The number of statements kept
+   */
+  void enableSlowQueryLog(std::chrono::nanoseconds threshold,
+                          std::size_t capacity = kDefaultSlowQueryCapacity);
+
+  /*!
+   * \brief Stop capturing slow statements. The captured ones are kept.
+   */
+  void disableSlowQueryLog();
+
+  /*!
+   * \brief Get the captured slow statements, from oldest to newest
+   */
+  std::vector<SlowQuery> slowQueries() const;
+
+  /*!
+   * \brief Format the captured slow statements, one per line (see
+   *        SlowQueryLog::dump())
+   */
+  std::string dumpSlowQueries() const;
+
+  /*!
+   * \brief Record which DAO statement a prepared statement is, so that
+   *        slow queries can be attributed to it
+   *
+   * Called by DAOs for the statements they keep for their lifetime.
+   *
+   * \param stmt The prepared statement
+   * \param table The DAO's table. Must outlive the database.
+   * \param statement Which of the DAO's statements it is. Must outlive the
+   *        database.
+   */
+  void registerStatement(const sqlite3_stmt* stmt,
+                         std::string_view table,
+                         std::string_view statement);
+
+private:
+  friend class ReadPool;
+  friend class Transaction;
+
+  //! Number of DAO slots per segment of the lookup table
+  static constexpr std::size_t kDAOSlotsPerSegment = 64;
+
+  //! Number of segments of the lookup table. Types with a slot beyond
+  //! the table are looked up in daos_ under the lock.
+  static constexpr std::size_t kDAOSegments = 64;
+
+  //! A fixed block of the DAO lookup table. Segments are never moved, so
+  //! readers can use them without a lock.
+  struct DAOSlotSegment
+  {
+    std::array<std::atomic<DAOBase*>, kDAOSlotsPerSegment> slots{};
+  };
+
+  /*!
+   * \brief Hand out the next free DAO slot number
+   *
+   * Slot numbers are shared by all databases in the process, so a type has
+   * the same slot everywhere.
+   */
+  static std::size_t nextDAOSlot();
+
+  /*!
+   * \brief The DAO slot of T, assigned on first use
+   */
+  template <ValidTransferObject T>
+  static std::size_t daoSlot()
+  {
+    static const std::size_t slot = nextDAOSlot();
+    return slot;
+  }
+
+  /*!
+   * \brief Look up a published DAO without taking a lock
+   * \return The DAO, or nullptr if it does not exist yet
+   */
+  DAOBase* findDAO(std::size_t slot) const
+  {
+    const std::size_t segment = slot / kDAOSlotsPerSegment;
+    if (segment >= kDAOSegments)
     {
-      LOG_SAFE(
-        pLogger_, spdlog::level::err, "Insert failed with code: {}", result);
+      return nullptr;
     }
 
-    return result == SQLITE_DONE;
+    const DAOSlotSegment* pSegment =
+      daoSegments_[segment].load(std::memory_order_acquire);
+    if (!pSegment)
+    {
+      return nullptr;
+    }
+
+    return pSegment->slots[slot % kDAOSlotsPerSegment].load(
+      std::memory_order_acquire);
   }
 
   /*!
-   * \brief Get raw SQLite database pointer for direct access
-   * \return Raw sqlite3* pointer
+   * \brief Create the DAO for T (unless another thread just did) and
+   *        publish it in the lookup table
    */
-  sqlite3& getRawDB();
+  template <ValidTransferObject T>
+  DataAccessObject<T>& createDAO(std::size_t slot)
+  {
+    // Recursive, since a DAO creates the DAOs of its nested types while
+    // it is being constructed
+    std::lock_guard<std::recursive_mutex> lock(daosMutex_);
+
+    auto typeIdx = std::type_index(typeid(T));
+    auto it = daos_.find(typeIdx);
+
+    if (it != daos_.end())
+    {
+      // Safe static_cast - we know the type from the map key
+      return static_cast<DataAccessObject<T>&>(*it->second);
+    }
+
+    auto dao = std::make_unique<DataAccessObject<T>>(*this, pLogger_);
+    auto& daoRef = *dao;
+    if (pActiveMetrics_)
+    {
+      daoRef.attachMetrics(pActiveMetrics_);
+    }
+    daos_.emplace(typeIdx, std::move(dao));
+
+    {
+      std::lock_guard<std::mutex> tablesLock(tablesMutex_);
+      daosByTable_.emplace(DataAccessObject<T>::tableName, &daoRef);
+    }
+
+    publishDAO(slot, daoRef);
+    return daoRef;
+  }
+
+  /*!
+   * \brief Make a fully constructed DAO visible to lock-free lookups.
+   *        Must be called with daosMutex_ held.
+   */
+  void publishDAO(std::size_t slot, DAOBase& dao);
+
+  /*!
+   * \brief Record metrics in a registry, or stop recording them
+   *
+   * Applies to every DAO, including those created later, and to the read
+   * pool. The read pool passes the writer's registry to its readers this
+   * way.
+   *
+   * \param pRegistry The registry, or nullptr to stop recording
+   */
+  void attachMetrics(const std::shared_ptr<MetricsRegistry>& pRegistry);
+
+  /*!
+   * \brief Capture slow statements of this connection in a log, or stop
+   *        capturing them
+   *
+   * Applies to the read pool as well. The read pool passes the writer's
+   * log to its readers this way.
+   *
+   * \param pLog The log, or nullptr to stop capturing
+   */
+  void attachSlowQueryLog(const std::shared_ptr<SlowQueryLog>& pLog);
+
+  /*!
+   * \brief sqlite3_trace_v2 callback that captures slow statements
+   *
+   * Runs on the thread that executed the statement, once it finishes.
+   */
+  static int onStatementTraced(unsigned type,
+                               void* pDatabase,
+                               void* pStmt,
+                               void* pNanos);
+
+  /*!
+   * \brief Run work on an executor and make its result awaitable
+   * \param executor Runs the work. Empty to run it immediately.
+   * \param work The work to run
+   */
+  template <typename R>
+  AsyncResult<R> runAsyncOn(Executor executor, std::function<R()> work)
+  {
+    if (!executor)
+    {
+      try
+      {
+        return AsyncResult<R>::ready(work());
+      }
+      catch (...)
+      {
+        return AsyncResult<R>::failed(std::current_exception());
+      }
+    }
+
+    return AsyncResult<R>{
+      [executor = std::move(executor), work = std::move(work)](
+        typename AsyncResult<R>::Completion done) mutable
+      {
+        executor(
+          [work = std::move(work), done]() mutable
+          {
+            // The completion resumes the caller, so it is not called
+            // inside the try block
+            std::optional<R> result;
+            std::exception_ptr error;
+            try
+            {
+              result.emplace(work());
+            }
+            catch (...)
+            {
+              error = std::current_exception();
+            }
+
+            if (error)
+            {
+              done.fail(std::move(error));
+            }
+            else
+            {
+              done(std::move(*result));
+            }
+          });
+      },
+      resumeExecutor_};
+  }
+
+  /*!
+   * \brief Apply the settings given at construction, logging the ones
+   *        SQLite did not accept
+   */
+  void applyOptions(bool allowWrite);
+
+  /*!
+   * \brief Run a PRAGMA statement
+   * \param pragma The PRAGMA without the keyword, e.g. "cache_size=-2000"
+   * \return The first value it returned, or an empty optional if it
+   *         failed or returned nothing
+   */
+  std::optional<std::string> queryPragma(std::string_view pragma);
+
+  /*!
+   * \brief Record which thread has a top-level transaction open on this
+   *        connection (a default ID when none is open)
+   */
+  void setTransactionOwner(std::thread::id owner);
+
+  /*!
+   * \brief sqlite3_update_hook callback that keeps the DAO select caches
+   *        coherent with every write made on this connection
+   *
+   * Runs inside sqlite3_step() on the writing thread. Writes to WITHOUT
+   * ROWID tables (the junction tables) and DELETEs without a WHERE clause
+   * do not invoke the hook; call DataAccessObject::clearCache() after
+   * such writes.
+   */
+  static void onRowWritten(void* pDatabase,
+                           int operation,
+                           const char* dbName,
+                           const char* tableName,
+                           sqlite3_int64 rowId);
+
+  /*!
+   * \brief sqlite3_rollback_hook callback that drops the cached rows of
+   *        the tables the rolled back transaction wrote to
+   *
+   * The update hook does not fire for the rows a rollback restores, so
+   * rows cached during the transaction (written through, or read back on
+   * this connection) would otherwise outlive it.
+   */
+  static void onRolledBack(void* pDatabase);
+
+  /*!
+   * \brief Clear the select caches of the tables written since the current
+   *        top-level transaction began
+   *
+   * Called by Transaction when it rolls back to a savepoint, which does
+   * not invoke the rollback hook. Clears every table the transaction wrote
+   * to, not only those written since the savepoint.
+   */
+  void clearTransactionCaches();
+
+  /*!
+   * \brief Forget the tables written by the current top-level transaction,
+   *        once it has been committed
+   */
+  void forgetTransactionWrites();
 
-private:
   //!< The unique pointer storing the SQLite database
   //!< object
   std::unique_ptr<sqlite3, decltype(&sqlite3_close)> db_;
@@ -389,6 +1144,94 @@ private:
 
   //! DAO storage using boost::unordered_map for better performance
   boost::unordered_map<std::type_index, std::unique_ptr<DAOBase>> daos_;
+
+  //! Guards daos_ against concurrent registration and iteration
+  mutable std::recursive_mutex daosMutex_;
+
+  //! Lock-free lookup table of the DAOs in daos_, indexed by DAO slot
+  std::array<std::atomic<DAOSlotSegment*>, kDAOSegments> daoSegments_;
+
+  //! Owns the segments of the lookup table. Guarded by daosMutex_.
+  std::array<std::unique_ptr<DAOSlotSegment>, kDAOSegments>
+    daoSegmentStorage_;
+
+  //! DAOs keyed by table name, for routing update hook calls. The names
+  //! are compile-time constants, so the keys never own memory.
+  std::unordered_map<std::string_view, DAOBase*> daosByTable_;
+
+  //! Guards daosByTable_. Separate from daosMutex_, which is held while
+  //! DAOs run SQL, so that the update hook never waits on it.
+  std::mutex tablesMutex_;
+
+  //! DAOs whose tables were written since the current top-level
+  //! transaction began. Guarded by tablesMutex_.
+  std::vector<DAOBase*> transactionWrites_;
+
+  //! The optional background writer. Declared after daos_ so that it is
+  //! destroyed (and performs its final flush) before the DAOs are.
+  std::unique_ptr<BackgroundWriter> pWriter_;
+
+  //! The optional write actor. Declared after daos_ so that it runs its
+  //! queued commands before the DAOs are destroyed.
+  std::unique_ptr<WriteActor> pActor_;
+
+  //! Runs the awaitable DAO operations, if set
+  Executor asyncExecutor_;
+
+  //! Runs the awaitable DAO operations that use this connection, one at a
+  //! time, on asyncExecutor_. Empty if asyncExecutor_ is.
+  Executor connectionExecutor_;
+
+  //! Resumes coroutines awaiting DAO operations, if set
+  Executor resumeExecutor_;
+
+  //! The worker threads started by startAsyncExecutor()
+  std::unique_ptr<ThreadPoolExecutor> pAsyncPool_;
+
+  //! The url the database was opened with, used to open readers
+  std::string url_;
+
+  //! The settings requested at construction, also used for readers
+  DatabaseOptions options_;
+
+  //! The optional pool of read connections
+  std::unique_ptr<ReadPool> pReadPool_;
+
+  //! The thread that has a Transaction open on this connection. Its reads
+  //! stay on this connection so that it sees its own uncommitted rows.
+  std::atomic<std::thread::id> transactionOwner_;
+
+  //! The per-statement metrics, created when they are first enabled.
+  //! Shared with the readers of the read pool. Guarded by daosMutex_.
+  std::shared_ptr<MetricsRegistry> pMetrics_;
+
+  //! The registry DAOs record into, null while metrics are disabled.
+  //! Guarded by daosMutex_.
+  MetricsRegistry* pActiveMetrics_;
+
+  //! The DAO table and statement of a registered prepared statement
+  struct StatementOrigin
+  {
+    //!< The DAO's table
+    std::string_view table;
+
+    //!< Which of the DAO's statements it is
+    std::string_view statement;
+  };
+
+  //! The origins of the statements DAOs keep, for slow query attribution
+  std::unordered_map<const sqlite3_stmt*, StatementOrigin> statementOrigins_;
+
+  //! Guards statementOrigins_
+  mutable std::mutex statementOriginsMutex_;
+
+  //! The slow query log, created when it is first enabled and then kept
+  //! for the lifetime of the database, since the trace callback uses it.
+  //! Shared with the readers of the read pool.
+  std::shared_ptr<SlowQueryLog> pSlowQueries_;
+
+  //! Whether slow statements are being captured. Guarded by daosMutex_.
+  bool slowQueryLogEnabled_;
 };
 
 // Implementation of ForeignKey::resolve() (needs Database definition)
@@ -396,12 +1239,66 @@ template <ValidTransferObject T>
 std::optional<std::reference_wrapper<const T>> ForeignKey<T>::resolve(
   Database& db)
 {
-  if (isSet() && data_ == std::nullopt)
+  if (isSet() && !data_)
   {
     data_ = db.getDAO<T>().selectCacheById(id);
   }
 
-  return data_;
+  if (!data_)
+  {
+    return std::nullopt;
+  }
+
+  return std::cref(*data_);
+}
+
+// Implementation of resolveAll() (needs Database definition)
+template <ForeignKeyRange R>
+std::size_t resolveAll(R&& keys, Database& db)
+{
+  using KeyType = std::remove_cvref_t<std::ranges::range_reference_t<R>>;
+  using T = ForeignKeyType<KeyType>;
+
+  // Keys are visited twice, so remember them for input ranges that can
+  // only be iterated once
+  std::vector<KeyType*> pending;
+  std::vector<uint32_t> ids;
+  std::size_t resolved = 0;
+  for (KeyType& key : keys)
+  {
+    if (key.data_)
+    {
+      ++resolved;
+    }
+    else if (key.isSet())
+    {
+      pending.push_back(&key);
+      ids.push_back(key.id);
+    }
+  }
+
+  if (pending.empty())
+  {
+    return resolved;
+  }
+
+  std::ranges::sort(ids);
+  auto duplicates = std::ranges::unique(ids);
+  ids.erase(duplicates.begin(), duplicates.end());
+
+  auto rows = db.getDAO<T>().selectCacheByIds(ids);
+
+  for (KeyType* key : pending)
+  {
+    auto it = rows.find(key->id);
+    if (it != rows.end())
+    {
+      key->data_ = it->second;
+      ++resolved;
+    }
+  }
+
+  return resolved;
 }
 
 }  // namespace cpp_sqlite
@@ -0,0 +1,125 @@
+#include "cpp_sqlite/src/cpp_sqlite/DBDatabaseOptions.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <type_traits>
+
+namespace cpp_sqlite
+{
+
+namespace
+{
+//! PRAGMA journal_mode values, indexed by JournalMode
+constexpr std::array<std::string_view, 6> journalModeNames{
+  "DELETE", "TRUNCATE", "PERSIST", "MEMORY", "WAL", "OFF"};
+
+//! Append "name=value" to a settings description
+template <typename V>
+void appendSetting(std::string& out, std::string_view name, const V& value)
+{
+  if (!out.empty())
+  {
+    out += ' ';
+  }
+  out += name;
+  out += '=';
+  if constexpr (std::is_convertible_v<V, std::string_view>)
+  {
+    out += value;
+  }
+  else
+  {
+    out += std::to_string(value);
+  }
+}
+}  // namespace
+
+DatabaseOptions DatabaseOptions::durable()
+{
+  DatabaseOptions options;
+  options.journalMode = JournalMode::WAL;
+  options.synchronous = SynchronousMode::Full;
+  options.busyTimeoutMs = 5000;
+  return options;
+}
+
+DatabaseOptions DatabaseOptions::fastIngest()
+{
+  DatabaseOptions options;
+  options.journalMode = JournalMode::WAL;
+  options.synchronous = SynchronousMode::Normal;
+  options.cacheSize = -64 * 1024;
+  options.tempStore = TempStore::Memory;
+  options.busyTimeoutMs = 5000;
+  return options;
+}
+
+DatabaseOptions DatabaseOptions::readMostly()
+{
+  DatabaseOptions options = fastIngest();
+  options.mmapSize = int64_t{256} * 1024 * 1024;
+  return options;
+}
+
+std::string DatabaseOptions::toString() const
+{
+  std::string out;
+  if (journalMode)
+  {
+    appendSetting(out, "journal_mode", toPragmaValue(*journalMode));
+  }
+  if (synchronous)
+  {
+    appendSetting(out, "synchronous", static_cast<int>(*synchronous));
+  }
+  if (cacheSize)
+  {
+    appendSetting(out, "cache_size", *cacheSize);
+  }
+  if (mmapSize)
+  {
+    appendSetting(out, "mmap_size", *mmapSize);
+  }
+  if (tempStore)
+  {
+    appendSetting(out, "temp_store", static_cast<int>(*tempStore));
+  }
+  if (pageSize)
+  {
+    appendSetting(out, "page_size", *pageSize);
+  }
+  if (busyTimeoutMs)
+  {
+    appendSetting(out, "busy_timeout", *busyTimeoutMs);
+  }
+  return out;
+}
+
+std::string_view toPragmaValue(JournalMode mode)
+{
+  return journalModeNames[static_cast<std::size_t>(mode)];
+}
+
+std::optional<JournalMode> parseJournalMode(std::string_view value)
+{
+  for (std::size_t i = 0; i < journalModeNames.size(); ++i)
+  {
+    const std::string_view name = journalModeNames[i];
+    if (name.size() == value.size() &&
+        std::equal(name.begin(),
+                   name.end(),
+                   value.begin(),
+                   [](char a, char b)
+                   {
+                     return std::toupper(static_cast<unsigned char>(a)) ==
+                            std::toupper(static_cast<unsigned char>(b));
+                   }))
+    {
+      return static_cast<JournalMode>(i);
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace cpp_sqlite
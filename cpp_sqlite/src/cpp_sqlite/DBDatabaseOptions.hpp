@@ -0,0 +1,125 @@
+#ifndef DB_DATABASE_OPTIONS_HPP
+#define DB_DATABASE_OPTIONS_HPP
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace cpp_sqlite
+{
+
+/*!
+ * \brief The SQLite journal modes (PRAGMA journal_mode)
+ */
+enum class JournalMode : uint8_t
+{
+  Delete,
+  Truncate,
+  Persist,
+  Memory,
+  WAL,
+  Off
+};
+
+/*!
+ * \brief How often SQLite syncs to disk (PRAGMA synchronous)
+ */
+enum class SynchronousMode : uint8_t
+{
+  Off,
+  Normal,
+  Full,
+  Extra
+};
+
+/*!
+ * \brief Where temporary tables and indices are kept (PRAGMA temp_store)
+ */
+enum class TempStore : uint8_t
+{
+  Default,
+  File,
+  Memory
+};
+
+/*!
+ * \brief Connection settings applied when a Database is opened
+ *
+ * Every setting is optional. Settings that are not given keep SQLite's
+ * default, so a default constructed DatabaseOptions opens the database
+ * exactly as SQLite would.
+ *
+ * page_size only takes effect on a new database file, and is applied
+ * before the journal mode because a WAL database cannot change it.
+ * Read-only connections skip the journal mode.
+ */
+struct DatabaseOptions
+{
+  //! PRAGMA journal_mode
+  std::optional<JournalMode> journalMode{};
+
+  //! PRAGMA synchronous
+  std::optional<SynchronousMode> synchronous{};
+
+  //! PRAGMA cache_size: pages if positive, KiB if negative
+  std::optional<int64_t> cacheSize{};
+
+  //! PRAGMA mmap_size in bytes (zero disables memory-mapped I/O)
+  std::optional<int64_t> mmapSize{};
+
+  //! PRAGMA temp_store
+  std::optional<TempStore> tempStore{};
+
+  //! PRAGMA page_size in bytes
+  std::optional<int64_t> pageSize{};
+
+  //! How long a connection retries when the database is locked
+  std::optional<int64_t> busyTimeoutMs{};
+
+  /*!
+   * \brief Settings that never lose a committed transaction
+   *
+   * WAL with synchronous=FULL, so every commit is synced.
+   */
+  static DatabaseOptions durable();
+
+  /*!
+   * \brief Settings for high-volume inserts
+   *
+   * WAL with synchronous=NORMAL. The database cannot be corrupted, but the
+   * most recent commits can be lost on power failure. Uses a 64 MiB page
+   * cache and in-memory temporary storage.
+   */
+  static DatabaseOptions fastIngest();
+
+  /*!
+   * \brief Settings for databases that are mostly queried
+   *
+   * fastIngest() plus 256 MiB of memory-mapped I/O, so that reads are
+   * served from the page cache of the OS without copying.
+   */
+  static DatabaseOptions readMostly();
+
+  /*!
+   * \brief Describe the settings, for example for logging
+   * \return "name=value" pairs separated by spaces, for the settings that
+   *         are set
+   */
+  std::string toString() const;
+};
+
+/*!
+ * \brief Get the PRAGMA value of a journal mode
+ */
+std::string_view toPragmaValue(JournalMode mode);
+
+/*!
+ * \brief Parse the result of PRAGMA journal_mode
+ * \return The mode, or an empty optional if the value is not recognized
+ */
+std::optional<JournalMode> parseJournalMode(std::string_view value);
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_DATABASE_OPTIONS_HPP
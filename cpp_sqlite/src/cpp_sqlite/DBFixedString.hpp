@@ -0,0 +1,48 @@
+#ifndef DB_FIXED_STRING_HPP
+#define DB_FIXED_STRING_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace cpp_sqlite
+{
+
+/*!
+ * \brief A null-terminated string of fixed length that can be built at
+ *        compile time and stored in static memory
+ * \tparam N The length without the terminator
+ */
+template <std::size_t N>
+struct FixedString
+{
+  constexpr FixedString() = default;
+
+  constexpr explicit FixedString(std::string_view text)
+  {
+    std::copy_n(text.begin(), std::min(N, text.size()), chars.begin());
+  }
+
+  constexpr std::string_view view() const
+  {
+    return {chars.data(), N};
+  }
+
+  constexpr const char* c_str() const
+  {
+    return chars.data();
+  }
+
+  constexpr operator std::string_view() const
+  {
+    return view();
+  }
+
+  //! The characters followed by a null terminator
+  std::array<char, N + 1> chars{};
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_FIXED_STRING_HPP
@@ -2,7 +2,11 @@
 #define DB_FOREIGN_KEY_HPP
 
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <ranges>
+#include <type_traits>
 
 #include <boost/describe.hpp>
 
@@ -55,8 +59,9 @@ struct ForeignKey
   //! The ID of the referenced object
   uint32_t id{0};
 
-  // The data stored in the foreign key table - loaded on demand
-  std::optional<std::reference_wrapper<const T>> data_;
+  // The data stored in the foreign key table - loaded on demand. Holding
+  // the pointer pins the row if the DAO's select cache evicts it.
+  std::shared_ptr<const T> data_;
 
   /*!
    * \brief Default
@@ -67,14 +72,16 @@ struct ForeignKey
   /*!
    * \brief Construct from an ID
    */
-  explicit ForeignKey(uint32_t foreignId) : id{foreignId}, data_{std::nullopt}
+  explicit ForeignKey(uint32_t foreignId) : id{foreignId}, data_{nullptr}
   {
   }
 
   /*!
    * \brief Resolve the foreign key to the full object
    * \param db Reference to the database
-   * \return Optional containing the loaded object, or empty if not found
+   * \return Optional containing the loaded object, or empty if not found.
+   *         The reference stays valid as long as this ForeignKey does not
+   *         change.
    */
   std::optional<std::reference_wrapper<const T>> resolve(Database& db);
 
@@ -87,6 +94,38 @@ struct ForeignKey
   }
 };
 
+/*!
+ * \brief A range whose elements are modifiable ForeignKeys
+ */
+template <typename R>
+concept ForeignKeyRange =
+  std::ranges::input_range<R> &&
+  std::is_lvalue_reference_v<std::ranges::range_reference_t<R>> &&
+  !std::is_const_v<
+    std::remove_reference_t<std::ranges::range_reference_t<R>>> &&
+  IsForeignKey<std::remove_cvref_t<std::ranges::range_reference_t<R>>>;
+
+/*!
+ * \brief Resolve every foreign key of a range at once
+ *
+ * The IDs of the unresolved keys are deduplicated, cached rows are taken
+ * from the select cache, and the misses are fetched with set-based
+ * queries instead of one selectById() per key. Every key is then bound
+ * as if resolve() had been called on it.
+ *
+ * Example:
+ * \code
+ * auto bodies = bodyDAO.selectAll();
+ * resolveAll(bodies | std::views::transform(&RigidBody::centerOfMass), db);
+ * \endcode
+ *
+ * \param keys The foreign keys to resolve
+ * \param db Reference to the database
+ * \return The number of keys that refer to an existing row
+ */
+template <ForeignKeyRange R>
+std::size_t resolveAll(R&& keys, Database& db);
+
 }  // namespace cpp_sqlite
 
 #endif  // DB_FOREIGN_KEY_HPP
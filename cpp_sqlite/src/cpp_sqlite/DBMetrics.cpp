@@ -0,0 +1,256 @@
+#include "cpp_sqlite/src/cpp_sqlite/DBMetrics.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+
+namespace cpp_sqlite
+{
+
+namespace
+{
+//! Statement names used in metric labels, indexed by StatementKind
+constexpr std::array<std::string_view, kStatementKindCount> statementNames{
+  "insert",
+  "insert_many",
+  "select_all",
+  "select_by_id",
+  "select_by_ids",
+  "junction_insert",
+  "junction_select"};
+
+//! log2 of the bounds of the exported histogram buckets, in nanoseconds:
+//! every other power of two from about 1 us to about 17 s. Powers of two
+//! are bucket boundaries of LatencyHistogram, so the counts are exact.
+constexpr std::array<unsigned, 13> exportedBucketExponents{
+  10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30, 32, 34};
+
+//! Append a label value, escaped as the text format requires
+void appendLabelValue(std::string& out, std::string_view value)
+{
+  for (char c : value)
+  {
+    switch (c)
+    {
+      case '\\':
+        out += "\\\\";
+        break;
+      case '"':
+        out += "\\\"";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      default:
+        out += c;
+    }
+  }
+}
+
+//! Append `{table="...",statement="..."` without the closing brace, so
+//! that more labels can follow
+void appendLabels(std::string& out, const StatementMetricsSnapshot& metrics)
+{
+  out += "{table=\"";
+  appendLabelValue(out, metrics.table);
+  out += "\",statement=\"";
+  out += toString(metrics.statement);
+  out += '"';
+}
+
+//! Append a number in its shortest exact form
+template <typename V>
+void appendNumber(std::string& out, V value)
+{
+  std::array<char, 32> buffer{};
+  const auto result =
+    std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+  out.append(buffer.data(), result.ptr);
+}
+
+//! Append ` value` and end the sample's line
+template <typename V>
+void appendValue(std::string& out, V value)
+{
+  out += ' ';
+  appendNumber(out, value);
+  out += '\n';
+}
+
+double toSeconds(uint64_t nanos)
+{
+  return static_cast<double>(nanos) / 1e9;
+}
+}  // namespace
+
+std::string_view toString(StatementKind kind)
+{
+  return statementNames[static_cast<std::size_t>(kind)];
+}
+
+uint64_t LatencySnapshot::percentile(double quantile) const
+{
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  quantile = std::clamp(quantile, 0.0, 1.0);
+  const auto rank = std::max<uint64_t>(
+    static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count))),
+    1);
+
+  uint64_t seen = 0;
+  for (std::size_t i = 0; i < counts.size(); ++i)
+  {
+    seen += counts[i];
+    if (seen >= rank)
+    {
+      // The largest value is known exactly
+      return std::min(LatencyHistogram::bucketLowerBound(i + 1), maxNanos);
+    }
+  }
+  return maxNanos;
+}
+
+uint64_t LatencySnapshot::countBelow(uint64_t nanos) const
+{
+  uint64_t below = 0;
+  for (std::size_t i = 0; i < counts.size(); ++i)
+  {
+    if (LatencyHistogram::bucketLowerBound(i + 1) > nanos)
+    {
+      break;
+    }
+    below += counts[i];
+  }
+  return below;
+}
+
+std::vector<uint64_t> LatencyHistogram::counts() const
+{
+  std::vector<uint64_t> result;
+  result.reserve(kBucketCount);
+  for (const auto& count : counts_)
+  {
+    result.push_back(count.load(std::memory_order_relaxed));
+  }
+  return result;
+}
+
+const StatementMetricsSnapshot* MetricsSnapshot::find(
+  std::string_view table,
+  StatementKind statement) const
+{
+  auto it = std::ranges::find_if(
+    statements,
+    [&](const StatementMetricsSnapshot& metrics)
+    { return metrics.table == table && metrics.statement == statement; });
+  return it == statements.end() ? nullptr : &*it;
+}
+
+std::string MetricsSnapshot::toPrometheus() const
+{
+  std::string out;
+
+  out += "# HELP cpp_sqlite_statement_calls_total "
+         "Executions of a prepared statement.\n"
+         "# TYPE cpp_sqlite_statement_calls_total counter\n";
+  for (const auto& metrics : statements)
+  {
+    out += "cpp_sqlite_statement_calls_total";
+    appendLabels(out, metrics);
+    out += '}';
+    appendValue(out, metrics.calls);
+  }
+
+  out += "# HELP cpp_sqlite_statement_rows_total "
+         "Rows read or written by a prepared statement.\n"
+         "# TYPE cpp_sqlite_statement_rows_total counter\n";
+  for (const auto& metrics : statements)
+  {
+    out += "cpp_sqlite_statement_rows_total";
+    appendLabels(out, metrics);
+    out += '}';
+    appendValue(out, metrics.rows);
+  }
+
+  out += "# HELP cpp_sqlite_statement_duration_seconds "
+         "Execution latency of a prepared statement.\n"
+         "# TYPE cpp_sqlite_statement_duration_seconds histogram\n";
+  for (const auto& metrics : statements)
+  {
+    const LatencySnapshot& latency = metrics.latency;
+    for (unsigned exponent : exportedBucketExponents)
+    {
+      const uint64_t bound = uint64_t{1} << exponent;
+      out += "cpp_sqlite_statement_duration_seconds_bucket";
+      appendLabels(out, metrics);
+      out += ",le=\"";
+      appendNumber(out, toSeconds(bound));
+      out += "\"}";
+      appendValue(out, latency.countBelow(bound));
+    }
+
+    out += "cpp_sqlite_statement_duration_seconds_bucket";
+    appendLabels(out, metrics);
+    out += ",le=\"+Inf\"}";
+    appendValue(out, latency.count);
+
+    out += "cpp_sqlite_statement_duration_seconds_sum";
+    appendLabels(out, metrics);
+    out += '}';
+    appendValue(out, toSeconds(latency.totalNanos));
+
+    out += "cpp_sqlite_statement_duration_seconds_count";
+    appendLabels(out, metrics);
+    out += '}';
+    appendValue(out, latency.count);
+  }
+
+  return out;
+}
+
+StatementMetricsSnapshot StatementMetrics::snapshot(
+  std::string table,
+  StatementKind statement) const
+{
+  StatementMetricsSnapshot result{};
+  result.table = std::move(table);
+  result.statement = statement;
+  result.calls = calls_.load(std::memory_order_relaxed);
+  result.rows = rows_.load(std::memory_order_relaxed);
+
+  LatencySnapshot& latency = result.latency;
+  latency.counts = histogram_.counts();
+  for (uint64_t count : latency.counts)
+  {
+    latency.count += count;
+  }
+  latency.totalNanos = totalNanos_.load(std::memory_order_relaxed);
+  latency.maxNanos = maxNanos_.load(std::memory_order_relaxed);
+  return result;
+}
+
+StatementMetrics& MetricsRegistry::get(std::string_view table,
+                                       StatementKind statement)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.try_emplace({std::string{table}, statement})
+    .first->second;
+}
+
+MetricsSnapshot MetricsRegistry::snapshot() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  MetricsSnapshot result{};
+  result.statements.reserve(entries_.size());
+  for (const auto& [key, metrics] : entries_)
+  {
+    result.statements.push_back(metrics.snapshot(key.first, key.second));
+  }
+  return result;
+}
+
+}  // namespace cpp_sqlite
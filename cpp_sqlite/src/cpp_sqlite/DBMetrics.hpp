@@ -0,0 +1,365 @@
+#ifndef DB_METRICS_HPP
+#define DB_METRICS_HPP
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cpp_sqlite
+{
+
+/*!
+ * \brief The prepared statements of a DAO that record metrics
+ */
+enum class StatementKind : uint8_t
+{
+  //! The single-row INSERT
+  Insert,
+  //! The multi-row INSERTs used when flushing flat rows
+  InsertMany,
+  //! SELECT of every row
+  SelectAll,
+  //! SELECT of one row by ID
+  SelectById,
+  //! SELECT of several rows by ID
+  SelectByIds,
+  //! INSERT of a parent/child link into a junction table
+  JunctionInsert,
+  //! SELECT of the children of several parents through a junction table
+  JunctionSelect
+};
+
+//! The number of StatementKind values
+inline constexpr std::size_t kStatementKindCount = 7;
+
+/*!
+ * \brief Get the name of a statement kind as used in metric labels, e.g.
+ *        "select_by_id"
+ */
+std::string_view toString(StatementKind kind);
+
+/*!
+ * \brief A copy of the counts of a LatencyHistogram
+ */
+struct LatencySnapshot
+{
+  //! The number of recorded latencies in each bucket
+  std::vector<uint64_t> counts;
+
+  //! The number of recorded latencies
+  uint64_t count{0};
+
+  //! The sum of the recorded latencies in nanoseconds
+  uint64_t totalNanos{0};
+
+  //! The largest recorded latency in nanoseconds
+  uint64_t maxNanos{0};
+
+  /*!
+   * \brief Get a latency quantile
+   *
+   * The result is the upper bound of the bucket holding the quantile, so
+   * it overstates the true value by at most one bucket width (12.5%).
+   *
+   * \param quantile The quantile, between 0 and 1 (e.g. 0.99)
+   * \return The latency in nanoseconds, or zero if nothing was recorded
+   */
+  uint64_t percentile(double quantile) const;
+
+  /*!
+   * \brief Get the number of recorded latencies below a bound
+   * \param nanos The bound in nanoseconds. Exact when it is a power of two.
+   */
+  uint64_t countBelow(uint64_t nanos) const;
+};
+
+/*!
+ * \brief A lock-free histogram of latencies with bounded relative error
+ *
+ * Like an HDR histogram, every power of two is split into a fixed number
+ * of linear sub-buckets, so each bucket is at most 12.5% wide relative to
+ * its values. Latencies from 1 ns up to about 18 minutes are tracked;
+ * larger ones are counted in the last bucket.
+ */
+class LatencyHistogram
+{
+public:
+  //! log2 of the number of sub-buckets per power of two
+  static constexpr unsigned kSubBucketBits = 3;
+
+  //! The number of sub-buckets per power of two
+  static constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBucketBits;
+
+  //! Latencies from 2^kMaxExponent nanoseconds on share the last bucket
+  static constexpr unsigned kMaxExponent = 40;
+
+  //! The number of buckets
+  static constexpr std::size_t kBucketCount =
+    (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+
+  /*!
+   * \brief Get the bucket that a latency is counted in
+   */
+  static constexpr std::size_t bucketIndex(uint64_t nanos)
+  {
+    if (nanos < kSubBuckets)
+    {
+      return static_cast<std::size_t>(nanos);
+    }
+
+    constexpr uint64_t maxValue = (uint64_t{1} << kMaxExponent) - 1;
+    nanos = nanos < maxValue ? nanos : maxValue;
+
+    const unsigned shift =
+      static_cast<unsigned>(std::bit_width(nanos)) - 1 - kSubBucketBits;
+    return static_cast<std::size_t>(
+      (shift + 1) * kSubBuckets + ((nanos >> shift) & (kSubBuckets - 1)));
+  }
+
+  /*!
+   * \brief Get the smallest latency counted in a bucket
+   */
+  static constexpr uint64_t bucketLowerBound(std::size_t index)
+  {
+    if (index < kSubBuckets)
+    {
+      return index;
+    }
+
+    const uint64_t shift = index / kSubBuckets - 1;
+    return (kSubBuckets + index % kSubBuckets) << shift;
+  }
+
+  /*!
+   * \brief Count one latency
+   */
+  void record(uint64_t nanos)
+  {
+    counts_[bucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /*!
+   * \brief Copy the bucket counts
+   */
+  std::vector<uint64_t> counts() const;
+
+private:
+  //! The number of latencies counted in each bucket
+  std::array<std::atomic<uint64_t>, kBucketCount> counts_{};
+};
+
+/*!
+ * \brief A copy of the metrics of one statement
+ */
+struct StatementMetricsSnapshot
+{
+  //! The table the statement reads or writes
+  std::string table;
+
+  //! Which of the table's statements this is
+  StatementKind statement{StatementKind::Insert};
+
+  //! The number of times the statement was executed
+  uint64_t calls{0};
+
+  //! The number of rows read or written
+  uint64_t rows{0};
+
+  //! The execution latencies
+  LatencySnapshot latency;
+};
+
+/*!
+ * \brief The metrics of every statement of a database at one point in
+ *        time
+ */
+struct MetricsSnapshot
+{
+  //! The statements that have metrics, ordered by table and statement
+  std::vector<StatementMetricsSnapshot> statements;
+
+  /*!
+   * \brief Find the metrics of one statement
+   * \return The metrics, or nullptr if the statement has none
+   */
+  const StatementMetricsSnapshot* find(std::string_view table,
+                                       StatementKind statement) const;
+
+  /*!
+   * \brief Format the metrics in the Prometheus text exposition format
+   *
+   * Every statement contributes, labelled by table and statement, to the
+   * counters cpp_sqlite_statement_calls_total and
+   * cpp_sqlite_statement_rows_total and to the histogram
+   * cpp_sqlite_statement_duration_seconds.
+   */
+  std::string toPrometheus() const;
+};
+
+/*!
+ * \brief Call counts, row counts and latencies of one prepared statement
+ *
+ * Recording is lock-free and may happen on any thread.
+ */
+class StatementMetrics
+{
+public:
+  /*!
+   * \brief Record one execution of the statement
+   * \param nanos How long it took
+   * \param rows The number of rows it read or wrote
+   */
+  void record(uint64_t nanos, uint64_t rows)
+  {
+    calls_.fetch_add(1, std::memory_order_relaxed);
+    rows_.fetch_add(rows, std::memory_order_relaxed);
+    totalNanos_.fetch_add(nanos, std::memory_order_relaxed);
+
+    uint64_t maxNanos = maxNanos_.load(std::memory_order_relaxed);
+    while (nanos > maxNanos && !maxNanos_.compare_exchange_weak(
+                                 maxNanos, nanos, std::memory_order_relaxed))
+    {
+    }
+
+    histogram_.record(nanos);
+  }
+
+  /*!
+   * \brief Copy the metrics
+   * \param table The table reported in the snapshot
+   * \param statement The statement reported in the snapshot
+   */
+  StatementMetricsSnapshot snapshot(std::string table,
+                                    StatementKind statement) const;
+
+private:
+  //! The number of executions
+  std::atomic<uint64_t> calls_{0};
+
+  //! The number of rows read or written
+  std::atomic<uint64_t> rows_{0};
+
+  //! The sum of the execution latencies in nanoseconds
+  std::atomic<uint64_t> totalNanos_{0};
+
+  //! The largest execution latency in nanoseconds
+  std::atomic<uint64_t> maxNanos_{0};
+
+  //! The execution latencies
+  LatencyHistogram histogram_;
+};
+
+/*!
+ * \brief Owns the StatementMetrics of the statements of a database
+ *
+ * Entries are created on first use and live as long as the registry, so
+ * DAOs can keep plain pointers to them. The read connections of a
+ * database share its registry, so reads are counted no matter which
+ * connection ran them.
+ */
+class MetricsRegistry
+{
+public:
+  /*!
+   * \brief Get (or create) the metrics of a statement
+   */
+  StatementMetrics& get(std::string_view table, StatementKind statement);
+
+  /*!
+   * \brief Copy the metrics of every statement
+   */
+  MetricsSnapshot snapshot() const;
+
+private:
+  //! Guards entries_
+  mutable std::mutex mutex_;
+
+  //! The metrics, keyed by table and statement. Map nodes never move.
+  std::map<std::pair<std::string, StatementKind>, StatementMetrics> entries_;
+};
+
+/*!
+ * \brief Times one execution of a statement and records it when destroyed
+ *
+ * Without metrics (a null StatementMetrics) the clock is never read. If
+ * the library is built with CPP_SQLITE_DISABLE_METRICS, the timer
+ * compiles to nothing.
+ */
+class StatementTimer
+{
+public:
+#ifdef CPP_SQLITE_DISABLE_METRICS
+  explicit StatementTimer(StatementMetrics*)
+  {
+  }
+
+  void addRows(uint64_t)
+  {
+  }
+#else
+  /*!
+   * \brief Start timing
+   * \param pMetrics Receives the execution, or nullptr to not record it
+   */
+  explicit StatementTimer(StatementMetrics* pMetrics)
+    : pMetrics_{pMetrics}, rows_{0}, start_{}
+  {
+    if (pMetrics_)
+    {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  /*!
+   * \brief Record the execution
+   */
+  ~StatementTimer()
+  {
+    if (pMetrics_)
+    {
+      const auto elapsed = std::chrono::steady_clock::now() - start_;
+      pMetrics_->record(
+        static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+            .count()),
+        rows_);
+    }
+  }
+
+  /*!
+   * \brief Count rows read or written by the execution
+   */
+  void addRows(uint64_t rows)
+  {
+    rows_ += rows;
+  }
+#endif
+
+  StatementTimer(const StatementTimer&) = delete;
+  StatementTimer& operator=(const StatementTimer&) = delete;
+
+#ifndef CPP_SQLITE_DISABLE_METRICS
+private:
+  //! Receives the execution, if set
+  StatementMetrics* pMetrics_;
+
+  //! The rows read or written so far
+  uint64_t rows_;
+
+  //! When the execution started
+  std::chrono::steady_clock::time_point start_;
+#endif
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_METRICS_HPP
@@ -0,0 +1,118 @@
+#include "cpp_sqlite/src/cpp_sqlite/DBReadPool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "cpp_sqlite/src/cpp_sqlite/DBDatabase.hpp"
+
+namespace cpp_sqlite
+{
+
+ReadLease::ReadLease(ReadPool& pool, Database& reader)
+  : pPool_{&pool}, pReader_{&reader}
+{
+}
+
+ReadLease::~ReadLease()
+{
+  release();
+}
+
+ReadLease::ReadLease(ReadLease&& other) noexcept
+  : pPool_{std::exchange(other.pPool_, nullptr)},
+    pReader_{std::exchange(other.pReader_, nullptr)}
+{
+}
+
+ReadLease& ReadLease::operator=(ReadLease&& other) noexcept
+{
+  if (this != &other)
+  {
+    release();
+    pPool_ = std::exchange(other.pPool_, nullptr);
+    pReader_ = std::exchange(other.pReader_, nullptr);
+  }
+  return *this;
+}
+
+void ReadLease::release()
+{
+  if (pPool_ && pReader_)
+  {
+    pPool_->release(*pReader_);
+  }
+  pPool_ = nullptr;
+  pReader_ = nullptr;
+}
+
+ReadPool::ReadPool(const std::string& url,
+                   std::size_t readerCount,
+                   std::shared_ptr<spdlog::logger> pLogger,
+                   const DatabaseOptions& options)
+  : readers_{},
+    freeReaders_{},
+    mutex_{},
+    readerFreed_{},
+    pLogger_{pLogger}
+{
+  readerCount = std::max<std::size_t>(readerCount, 1);
+  readers_.reserve(readerCount);
+  freeReaders_.reserve(readerCount);
+
+  for (std::size_t i = 0; i < readerCount; ++i)
+  {
+    readers_.push_back(
+      std::make_unique<Database>(url, false, pLogger_, options));
+    freeReaders_.push_back(readers_.back().get());
+  }
+
+  LOG_SAFE(pLogger_,
+           spdlog::level::debug,
+           "Opened {} read connections to {}",
+           readerCount,
+           url);
+}
+
+ReadPool::~ReadPool() = default;
+
+ReadLease ReadPool::acquire()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  readerFreed_.wait(lock, [this] { return !freeReaders_.empty(); });
+
+  Database* reader = freeReaders_.back();
+  freeReaders_.pop_back();
+  return ReadLease{*this, *reader};
+}
+
+std::size_t ReadPool::size() const
+{
+  return readers_.size();
+}
+
+void ReadPool::attachMetrics(const std::shared_ptr<MetricsRegistry>& pRegistry)
+{
+  for (auto& reader : readers_)
+  {
+    reader->attachMetrics(pRegistry);
+  }
+}
+
+void ReadPool::attachSlowQueryLog(const std::shared_ptr<SlowQueryLog>& pLog)
+{
+  for (auto& reader : readers_)
+  {
+    reader->attachSlowQueryLog(pLog);
+  }
+}
+
+void ReadPool::release(Database& reader)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    freeReaders_.push_back(&reader);
+  }
+  readerFreed_.notify_one();
+}
+
+}  // namespace cpp_sqlite
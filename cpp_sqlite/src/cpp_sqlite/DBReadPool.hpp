@@ -0,0 +1,165 @@
+#ifndef DB_READ_POOL_HPP
+#define DB_READ_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "cpp_sqlite/src/cpp_sqlite/DBDatabaseOptions.hpp"
+#include "cpp_sqlite/src/utils/Logger.hpp"
+
+namespace cpp_sqlite
+{
+
+class Database;
+class MetricsRegistry;
+class ReadPool;
+class SlowQueryLog;
+
+/*!
+ * \brief Exclusive use of one read connection of a ReadPool
+ *
+ * The connection is returned to the pool when the lease is destroyed. An
+ * empty lease (one that converts to false) means the read should run on
+ * the writer connection instead.
+ */
+class ReadLease
+{
+public:
+  ReadLease() = default;
+
+  /*!
+   * \brief Take the given reader of a pool
+   */
+  ReadLease(ReadPool& pool, Database& reader);
+
+  /*!
+   * \brief Return the reader to its pool
+   */
+  ~ReadLease();
+
+  ReadLease(const ReadLease&) = delete;
+  ReadLease& operator=(const ReadLease&) = delete;
+  ReadLease(ReadLease&& other) noexcept;
+  ReadLease& operator=(ReadLease&& other) noexcept;
+
+  /*!
+   * \brief Check whether the lease holds a reader
+   */
+  explicit operator bool() const
+  {
+    return pReader_ != nullptr;
+  }
+
+  Database& operator*() const
+  {
+    return *pReader_;
+  }
+
+  Database* operator->() const
+  {
+    return pReader_;
+  }
+
+private:
+  /*!
+   * \brief Return the reader to its pool, leaving the lease empty
+   */
+  void release();
+
+  //! The pool the reader belongs to
+  ReadPool* pPool_{nullptr};
+
+  //! The leased reader
+  Database* pReader_{nullptr};
+};
+
+/*!
+ * \brief A fixed set of read-only connections to a database file
+ *
+ * Every reader is a read-only Database with its own DAOs, so each
+ * connection has its own prepared statements. A reader is used by one
+ * thread at a time: acquire() hands out a free reader, blocking until one
+ * is returned if all of them are in use.
+ *
+ * With the writer connection in WAL mode, readers see the last committed
+ * state of the database and neither wait for the writer nor hold it up.
+ */
+class ReadPool
+{
+public:
+  /*!
+   * \brief Open the read connections
+   * \param url The database file to open
+   * \param readerCount The number of read connections
+   * \param pLogger Optional logger
+   * \param options Settings applied to every read connection
+   * \throws std::runtime_error If a connection could not be opened
+   */
+  ReadPool(const std::string& url,
+           std::size_t readerCount,
+           std::shared_ptr<spdlog::logger> pLogger = nullptr,
+           const DatabaseOptions& options = {});
+
+  /*!
+   * \brief Close the read connections. No lease may outlive the pool.
+   */
+  ~ReadPool();
+
+  ReadPool(const ReadPool&) = delete;
+  ReadPool& operator=(const ReadPool&) = delete;
+  ReadPool(ReadPool&&) = delete;
+  ReadPool& operator=(ReadPool&&) = delete;
+
+  /*!
+   * \brief Lease a free reader, waiting for one if all are in use
+   */
+  ReadLease acquire();
+
+  /*!
+   * \brief Get the number of read connections
+   */
+  std::size_t size() const;
+
+  /*!
+   * \brief Record the metrics of every reader in a registry
+   * \param pRegistry The registry, or nullptr to stop recording
+   */
+  void attachMetrics(const std::shared_ptr<MetricsRegistry>& pRegistry);
+
+  /*!
+   * \brief Capture the slow statements of every reader in a log
+   * \param pLog The log, or nullptr to stop capturing
+   */
+  void attachSlowQueryLog(const std::shared_ptr<SlowQueryLog>& pLog);
+
+private:
+  friend class ReadLease;
+
+  /*!
+   * \brief Put a leased reader back on the free list
+   */
+  void release(Database& reader);
+
+  //! The read connections
+  std::vector<std::unique_ptr<Database>> readers_;
+
+  //! The readers that are not leased
+  std::vector<Database*> freeReaders_;
+
+  //! Guards freeReaders_
+  std::mutex mutex_;
+
+  //! Wakes threads waiting for a free reader
+  std::condition_variable readerFreed_;
+
+  //! The local logger
+  std::shared_ptr<spdlog::logger> pLogger_;
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_READ_POOL_HPP
@@ -0,0 +1,354 @@
+#ifndef DB_RING_BUFFER_HPP
+#define DB_RING_BUFFER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace cpp_sqlite
+{
+
+/*!
+ * \brief Selects the container that backs a DAO's write buffer
+ */
+enum class BufferBackend : uint8_t
+{
+  //! A std::vector guarded by a mutex (the default)
+  Mutex,
+  //! A bounded lock-free multi-producer/single-consumer ring buffer
+  LockFree
+};
+
+/*!
+ * \brief What a lock-free buffer does when a producer finds it full
+ */
+enum class BufferFullPolicy : uint8_t
+{
+  //! Spin (yielding) until the consumer has made room
+  Block,
+  //! Discard the row and count it as dropped
+  Drop,
+  //! Spill the row into an unbounded, mutex-guarded overflow list
+  Grow
+};
+
+/*!
+ * \brief Counters describing how a write buffer has been used
+ */
+struct BufferStats
+{
+  //! Rows discarded because the buffer was full
+  uint64_t dropped{0};
+
+  //! Rows spilled into the overflow list because the buffer was full
+  uint64_t overflowed{0};
+
+  //! The largest number of rows that were buffered at once
+  std::size_t highWaterMark{0};
+};
+
+//! Alignment used to keep producer and consumer counters on separate
+//! cache lines
+inline constexpr std::size_t kCacheLineSize = 64;
+
+/*!
+ * \brief A bounded lock-free multi-producer/single-consumer queue
+ *
+ * Based on Dmitry Vyukov's bounded queue: every cell carries a sequence
+ * number that tells producers and the consumer whether the cell is free
+ * or holds a value, so producers only contend on a single atomic
+ * increment of the enqueue position.
+ *
+ * Any number of threads may call push(). Only one thread at a time may
+ * call tryPop() or drain().
+ *
+ * With the Grow policy, once a value has spilled into the overflow list
+ * every later push() goes there too until the consumer drains it. The
+ * ring buffer then only holds values older than the spilled ones, so
+ * drain() keeps the order in which each producer pushed its values.
+ *
+ * \tparam T The element type, must be default constructible and movable
+ */
+template <typename T>
+class MPSCRingBuffer
+{
+public:
+  /*!
+   * \brief Create a ring buffer
+   * \param capacity The number of slots, rounded up to a power of two
+   * \param fullPolicy What push() does when the buffer is full
+   */
+  explicit MPSCRingBuffer(std::size_t capacity,
+                          BufferFullPolicy fullPolicy = BufferFullPolicy::Block)
+    : mask_{std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1},
+      cells_{std::make_unique<Cell[]>(mask_ + 1)},
+      fullPolicy_{fullPolicy},
+      enqueuePos_{0},
+      dequeuePos_{0},
+      dropped_{0},
+      overflowed_{0},
+      highWaterMark_{0},
+      overflowSize_{0},
+      overflowMutex_{},
+      overflow_{}
+  {
+    for (std::size_t i = 0; i <= mask_; ++i)
+    {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MPSCRingBuffer(const MPSCRingBuffer&) = delete;
+  MPSCRingBuffer& operator=(const MPSCRingBuffer&) = delete;
+
+  /*!
+   * \brief Add a value, applying the full policy if there is no room
+   * \return False if the value was dropped
+   */
+  template <typename U>
+  bool push(U&& value)
+  {
+    if (fullPolicy_ == BufferFullPolicy::Grow &&
+        overflowSize_.load(std::memory_order_relaxed) > 0 &&
+        spill(std::forward<U>(value), false))
+    {
+      return true;
+    }
+
+    while (!tryPush<U>(value))
+    {
+      switch (fullPolicy_)
+      {
+        case BufferFullPolicy::Drop:
+          dropped_.fetch_add(1, std::memory_order_relaxed);
+          return false;
+
+        case BufferFullPolicy::Grow:
+          spill(std::forward<U>(value), true);
+          return true;
+
+        case BufferFullPolicy::Block:
+          std::this_thread::yield();
+          break;
+      }
+    }
+
+    return true;
+  }
+
+  /*!
+   * \brief Remove the oldest value (consumer thread only)
+   * \return False if the ring buffer is empty
+   */
+  bool tryPop(T& out)
+  {
+    std::size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    Cell& cell = cells_[pos & mask_];
+
+    std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+    if (static_cast<std::ptrdiff_t>(sequence - (pos + 1)) < 0)
+    {
+      return false;
+    }
+
+    out = std::move(cell.value);
+
+    // Mark the cell free for the producer one lap ahead
+    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+    dequeuePos_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /*!
+   * \brief Move every queued value, including spilled ones, to the back of
+   *        a vector (consumer thread only)
+   * \return The number of values moved
+   */
+  std::size_t drain(std::vector<T>& out)
+  {
+    std::size_t count = 0;
+
+    T value{};
+    while (tryPop(value))
+    {
+      out.push_back(std::move(value));
+      ++count;
+    }
+
+    std::lock_guard<std::mutex> lock(overflowMutex_);
+    if (!overflow_.empty())
+    {
+      count += overflow_.size();
+      std::move(overflow_.begin(), overflow_.end(), std::back_inserter(out));
+      overflow_.clear();
+      overflowSize_.store(0, std::memory_order_relaxed);
+    }
+
+    return count;
+  }
+
+  /*!
+   * \brief Approximate number of queued values, including spilled ones
+   */
+  std::size_t size() const
+  {
+    std::size_t enqueued = enqueuePos_.load(std::memory_order_relaxed);
+    std::size_t dequeued = dequeuePos_.load(std::memory_order_relaxed);
+    std::size_t queued = enqueued > dequeued ? enqueued - dequeued : 0;
+    return queued + overflowSize_.load(std::memory_order_relaxed);
+  }
+
+  /*!
+   * \brief The number of slots in the ring buffer
+   */
+  std::size_t capacity() const
+  {
+    return mask_ + 1;
+  }
+
+  /*!
+   * \brief Get the drop, overflow and high-water counters
+   */
+  BufferStats stats() const
+  {
+    BufferStats result{};
+    result.dropped = dropped_.load(std::memory_order_relaxed);
+    result.overflowed = overflowed_.load(std::memory_order_relaxed);
+    result.highWaterMark = highWaterMark_.load(std::memory_order_relaxed);
+    return result;
+  }
+
+private:
+  /*!
+   * \brief Append a value to the overflow list
+   * \param force Append even if the consumer has drained the list since
+   *              the caller last checked it
+   * \return False if the list was empty and force was not set
+   */
+  template <typename U>
+  bool spill(U&& value, bool force)
+  {
+    std::lock_guard<std::mutex> lock(overflowMutex_);
+    if (!force && overflow_.empty())
+    {
+      return false;
+    }
+
+    overflow_.emplace_back(std::forward<U>(value));
+    overflowSize_.store(overflow_.size(), std::memory_order_relaxed);
+    overflowed_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  /*!
+   * \brief Try to claim a cell and store the value in it
+   * \return False if the ring buffer is full
+   */
+  template <typename U>
+  bool tryPush(U& value)
+  {
+    std::size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+
+    for (;;)
+    {
+      cell = &cells_[pos & mask_];
+      std::size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      auto diff = static_cast<std::ptrdiff_t>(sequence - pos);
+
+      if (diff == 0)
+      {
+        if (enqueuePos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed))
+        {
+          break;
+        }
+      }
+      else if (diff < 0)
+      {
+        return false;
+      }
+      else
+      {
+        pos = enqueuePos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->value = std::forward<U>(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+
+    updateHighWaterMark(pos + 1);
+    return true;
+  }
+
+  /*!
+   * \brief Raise the high-water mark if the queue just grew past it
+   */
+  void updateHighWaterMark(std::size_t enqueued)
+  {
+    std::size_t dequeued = dequeuePos_.load(std::memory_order_relaxed);
+    std::size_t current = enqueued > dequeued ? enqueued - dequeued : 0;
+
+    std::size_t mark = highWaterMark_.load(std::memory_order_relaxed);
+    while (current > mark &&
+           !highWaterMark_.compare_exchange_weak(
+             mark, current, std::memory_order_relaxed))
+    {
+    }
+  }
+
+  //! A slot of the ring buffer
+  struct Cell
+  {
+    //! Tells producers and the consumer who owns the cell
+    std::atomic<std::size_t> sequence;
+
+    //! The stored value
+    T value;
+  };
+
+  //! Capacity minus one, used to wrap positions onto cells
+  const std::size_t mask_;
+
+  //! The slots of the ring buffer
+  std::unique_ptr<Cell[]> cells_;
+
+  //! What push() does when the buffer is full
+  const BufferFullPolicy fullPolicy_;
+
+  //! Next position producers write to
+  alignas(kCacheLineSize) std::atomic<std::size_t> enqueuePos_;
+
+  //! Next position the consumer reads from
+  alignas(kCacheLineSize) std::atomic<std::size_t> dequeuePos_;
+
+  //! Rows discarded because the buffer was full
+  alignas(kCacheLineSize) std::atomic<uint64_t> dropped_;
+
+  //! Rows spilled to the overflow list
+  std::atomic<uint64_t> overflowed_;
+
+  //! The largest observed queue length
+  std::atomic<std::size_t> highWaterMark_;
+
+  //! Length of the overflow list, readable without taking its mutex
+  std::atomic<std::size_t> overflowSize_;
+
+  //! Guards the overflow list
+  std::mutex overflowMutex_;
+
+  //! Rows that did not fit into the ring buffer (Grow policy only)
+  std::vector<T> overflow_;
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_RING_BUFFER_HPP
@@ -0,0 +1,329 @@
+#ifndef DB_ROW_VIEW_HPP
+#define DB_ROW_VIEW_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+#include <boost/describe.hpp>
+#include <boost/mp11.hpp>
+#include "sqlite3.h"
+
+#include "cpp_sqlite/src/cpp_sqlite/DBTraits.hpp"
+#include "cpp_sqlite/src/utils/Logger.hpp"
+
+namespace cpp_sqlite
+{
+
+/*!
+ * \brief The column of a SELECT of T that holds a given member
+ *
+ * Follows the column layout of detail::appendSelectSource(): the
+ * columns of a nested transfer object directly follow its `_id` column.
+ *
+ * \return The zero-based column offset, or -1 if Member is not a
+ *         described member of T
+ */
+template <typename T, auto Member>
+consteval int selectColumnOffset()
+{
+  int column = 0;
+  int found = -1;
+  boost::mp11::mp_for_each<boost::describe::describe_members<
+    T,
+    boost::describe::mod_inherited | boost::describe::mod_public>>(
+    [&](auto D)
+    {
+      using memberType = std::remove_cv_t<
+        std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+
+      if constexpr (std::is_same_v<std::remove_cv_t<decltype(D.pointer)>,
+                                   decltype(Member)>)
+      {
+        if (found < 0 && D.pointer == Member)
+        {
+          found = column;
+        }
+      }
+
+      if constexpr (IsRepeatedFieldTransferObject<memberType>)
+      {
+        // Stored in a junction table
+      }
+      else if constexpr (ValidTransferObject<memberType>)
+      {
+        column += 1 + static_cast<int>(selectColumnCount<memberType>());
+      }
+      else if constexpr (IsForeignKey<memberType> ||
+                         isSupportedDBType<memberType>)
+      {
+        ++column;
+      }
+    });
+  return found;
+}
+
+/*!
+ * \brief A zero-copy view of the columns of T in the current row of a
+ *        statement
+ *
+ * Members are read straight from SQLite's column buffers with
+ * get<&T::member>(). TEXT columns are returned as std::string_view and
+ * BLOB columns as std::span<const uint8_t>, so scanning rows copies
+ * nothing. The returned views are only valid until the statement is
+ * stepped or reset.
+ *
+ * Example:
+ * \code
+ * for (auto row : docDAO.selectAllViews())
+ * {
+ *   totalBytes += row.get<&DocumentRecord::file_data>().size();
+ * }
+ * \endcode
+ *
+ * \tparam T The transfer object whose columns are viewed
+ */
+template <ValidTransferObject T>
+class RowView
+{
+public:
+  /*!
+   * \brief View the columns of T in a statement
+   * \param stmt The statement positioned on a row
+   * \param firstColumn The column holding the first member of T
+   */
+  RowView(sqlite3_stmt* stmt, int firstColumn)
+    : stmt_{stmt}, firstColumn_{firstColumn}
+  {
+  }
+
+  /*!
+   * \brief Read a member of T from the current row
+   *
+   * \tparam Member A pointer to a described member of T
+   * \return The value for arithmetic members, a std::string_view for
+   *         strings, a std::span<const uint8_t> for BLOBs, the referenced
+   *         ID for foreign keys, and a RowView for nested transfer objects
+   */
+  template <auto Member>
+  auto get() const
+  {
+    using memberType = std::remove_cv_t<
+      std::remove_reference_t<decltype(std::declval<T&>().*Member)>>;
+
+    constexpr int offset = selectColumnOffset<T, Member>();
+    static_assert(offset >= 0, "Member is not a described member of T");
+    static_assert(!IsRepeatedFieldTransferObject<memberType>,
+                  "Repeated fields are not part of the row");
+
+    const int column = firstColumn_ + offset;
+
+    if constexpr (IsForeignKey<memberType>)
+    {
+      return static_cast<uint32_t>(sqlite3_column_int64(stmt_, column));
+    }
+    else if constexpr (ValidTransferObject<memberType>)
+    {
+      // The nested object's columns follow its `_id` column
+      return RowView<memberType>{stmt_, column + 1};
+    }
+    else if constexpr (isIntegral<memberType>)
+    {
+      return static_cast<memberType>(sqlite3_column_int64(stmt_, column));
+    }
+    else if constexpr (floatingPoint<memberType>)
+    {
+      return static_cast<memberType>(sqlite3_column_double(stmt_, column));
+    }
+    else if constexpr (isString<memberType>)
+    {
+      // sqlite3_column_bytes must be called after sqlite3_column_text
+      const unsigned char* text = sqlite3_column_text(stmt_, column);
+      const int size = sqlite3_column_bytes(stmt_, column);
+      if (!text)
+      {
+        return std::string_view{};
+      }
+      return std::string_view{reinterpret_cast<const char*>(text),
+                              static_cast<std::size_t>(size)};
+    }
+    else if constexpr (isBlob<memberType>)
+    {
+      const void* blobData = sqlite3_column_blob(stmt_, column);
+      const int size = sqlite3_column_bytes(stmt_, column);
+      if (!blobData)
+      {
+        return std::span<const uint8_t>{};
+      }
+      return std::span<const uint8_t>{static_cast<const uint8_t*>(blobData),
+                                      static_cast<std::size_t>(size)};
+    }
+  }
+
+  /*!
+   * \brief Check whether the viewed row is missing
+   *
+   * True for a nested object whose row was not found by the LEFT JOIN.
+   */
+  bool isNull() const
+  {
+    return sqlite3_column_type(stmt_, firstColumn_) == SQLITE_NULL;
+  }
+
+private:
+  //! The statement positioned on the viewed row
+  sqlite3_stmt* stmt_;
+
+  //! The column holding the first member of T
+  int firstColumn_;
+};
+
+/*!
+ * \brief A single-pass range of RowViews over the rows of a SELECT
+ *        statement
+ *
+ * Every increment steps the statement once and nothing is decoded until
+ * a member is read. A RowView (and anything read from it) is only valid
+ * until the cursor advances. Repeated fields are not loaded.
+ *
+ * \tparam T The transfer object whose columns are viewed
+ */
+template <ValidTransferObject T>
+class RowViewCursor
+{
+public:
+  /*!
+   * \brief Input iterator over the rows of a view cursor
+   */
+  class iterator
+  {
+  public:
+    using iterator_concept = std::input_iterator_tag;
+    using iterator_category = std::input_iterator_tag;
+    using value_type = RowView<T>;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+
+    explicit iterator(RowViewCursor* cursor) : cursor_{cursor}
+    {
+    }
+
+    RowView<T> operator*() const
+    {
+      return RowView<T>{cursor_->stmt_.get(), 0};
+    }
+
+    iterator& operator++()
+    {
+      cursor_->step();
+      return *this;
+    }
+
+    void operator++(int)
+    {
+      ++*this;
+    }
+
+    friend bool operator==(const iterator& it, std::default_sentinel_t)
+    {
+      return it.atEnd();
+    }
+
+  private:
+    /*!
+     * \brief Check whether the cursor has no more rows
+     */
+    bool atEnd() const
+    {
+      return cursor_ == nullptr || cursor_->done_;
+    }
+
+    //! The cursor the iterator reads from
+    RowViewCursor* cursor_{nullptr};
+  };
+
+  /*!
+   * \brief Create a view cursor over a prepared SELECT statement
+   * \param stmt The statement to step. A null statement yields no rows.
+   * \param pLogger Optional logger for reporting failures
+   */
+  explicit RowViewCursor(PreparedSQLStmt stmt,
+                         std::shared_ptr<spdlog::logger> pLogger = nullptr)
+    : stmt_{std::move(stmt)},
+      started_{false},
+      done_{stmt_ == nullptr},
+      pLogger_{pLogger}
+  {
+  }
+
+  RowViewCursor(const RowViewCursor&) = delete;
+  RowViewCursor& operator=(const RowViewCursor&) = delete;
+  RowViewCursor(RowViewCursor&&) = default;
+
+  /*!
+   * \brief Get an iterator positioned on the first row not yet read
+   */
+  iterator begin()
+  {
+    if (!started_)
+    {
+      started_ = true;
+      step();
+    }
+    return iterator{this};
+  }
+
+  std::default_sentinel_t end() const
+  {
+    return std::default_sentinel;
+  }
+
+private:
+  /*!
+   * \brief Step the statement to the next row
+   */
+  void step()
+  {
+    if (done_)
+    {
+      return;
+    }
+
+    int result = sqlite3_step(stmt_.get());
+    if (result != SQLITE_ROW)
+    {
+      if (result != SQLITE_DONE)
+      {
+        LOG_SAFE(pLogger_,
+                 spdlog::level::err,
+                 "Cursor step failed with code: {}",
+                 result);
+      }
+
+      // Release the read transaction as soon as the rows are exhausted
+      sqlite3_reset(stmt_.get());
+      done_ = true;
+    }
+  }
+
+  //! The SELECT statement owned by this cursor
+  PreparedSQLStmt stmt_;
+
+  //! Whether the first row has been stepped to
+  bool started_;
+
+  //! Whether the statement has returned its last row
+  bool done_;
+
+  //! The local logger
+  std::shared_ptr<spdlog::logger> pLogger_;
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_ROW_VIEW_HPP
@@ -0,0 +1,356 @@
+#ifndef DB_SELECT_CACHE_HPP
+#define DB_SELECT_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+
+#include <boost/describe.hpp>
+#include <boost/mp11.hpp>
+
+#include "cpp_sqlite/src/cpp_sqlite/DBTraits.hpp"
+
+namespace cpp_sqlite
+{
+
+/*!
+ * \brief Selects which entry a DAO's select cache evicts when it is full
+ */
+enum class CachePolicy : uint8_t
+{
+  //! Never evict. Every resolved row stays cached for the DAO's lifetime.
+  Unbounded,
+  //! Evict the least recently used entry
+  LRU,
+  //! Evict with the CLOCK (second chance) approximation of LRU. A hit
+  //! only sets a flag, so lookups never reorder the cache.
+  Clock
+};
+
+/*!
+ * \brief Counters describing how a select cache has been used
+ */
+struct CacheStats
+{
+  //! Lookups answered from the cache
+  uint64_t hits{0};
+
+  //! Lookups that had to query the database
+  uint64_t misses{0};
+
+  //! Entries dropped to stay within the cache limits
+  uint64_t evictions{0};
+
+  //! The number of cached entries
+  std::size_t entries{0};
+
+  //! The estimated memory held by the cached entries
+  std::size_t bytes{0};
+};
+
+/*!
+ * \brief Estimate the heap memory owned by the members of a transfer object
+ *
+ * Counts the capacity of strings, BLOBs and repeated fields, and recurses
+ * into nested and repeated transfer objects. The object itself is not
+ * counted.
+ */
+template <typename T>
+std::size_t dynamicMemberSize(const T& obj)
+{
+  std::size_t size = 0;
+  boost::mp11::mp_for_each<boost::describe::describe_members<
+    T,
+    boost::describe::mod_inherited | boost::describe::mod_public>>(
+    [&](auto D)
+    {
+      using memberType = std::remove_cv_t<
+        std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+      const auto& member = obj.*D.pointer;
+
+      if constexpr (IsRepeatedFieldTransferObject<memberType>)
+      {
+        using childType = typename decltype(member.data)::value_type;
+        size += member.data.capacity() * sizeof(childType);
+        for (const auto& child : member.data)
+        {
+          size += dynamicMemberSize(child);
+        }
+      }
+      else if constexpr (ValidTransferObject<memberType>)
+      {
+        size += dynamicMemberSize(member);
+      }
+      else if constexpr (isString<memberType> || isBlob<memberType>)
+      {
+        size += member.capacity();
+      }
+    });
+  return size;
+}
+
+/*!
+ * \brief A bounded cache of rows loaded by ID
+ *
+ * Entries are limited by count, by an estimated size in bytes, or both,
+ * and the policy decides which entry goes first. Rows are handed out as
+ * std::shared_ptr<const T>, which pins them: evicting an entry only drops
+ * the cache's reference, so rows that are still in use (for example by a
+ * resolved ForeignKey) stay valid until their last holder releases them.
+ *
+ * The cache is not thread-safe.
+ *
+ * \tparam T The cached transfer object
+ */
+template <ValidTransferObject T>
+class SelectCache
+{
+public:
+  /*!
+   * \brief Create a cache
+   * \param policy The eviction policy
+   * \param maxEntries The maximum number of entries (zero means no limit)
+   * \param maxBytes The maximum estimated size in bytes (zero means no
+   *        limit)
+   */
+  SelectCache(CachePolicy policy, std::size_t maxEntries, std::size_t maxBytes)
+    : entries_{},
+      order_{},
+      hand_{order_.end()},
+      policy_{policy},
+      maxEntries_{maxEntries},
+      maxBytes_{maxBytes},
+      stats_{}
+  {
+  }
+
+  /*!
+   * \brief Change the policy and limits, evicting entries that no longer
+   *        fit
+   */
+  void configure(CachePolicy policy,
+                 std::size_t maxEntries,
+                 std::size_t maxBytes)
+  {
+    policy_ = policy;
+    maxEntries_ = maxEntries;
+    maxBytes_ = maxBytes;
+
+    // Entries are already in recency order for LRU, and CLOCK only needs
+    // its reference flags cleared to start a fresh sweep
+    hand_ = order_.begin();
+    for (auto& [id, entry] : entries_)
+    {
+      entry.referenced = false;
+    }
+
+    evictToFit();
+  }
+
+  /*!
+   * \brief Look up a cached row, counting the lookup as a hit or miss
+   * \return The pinned row, or nullptr if it is not cached
+   */
+  std::shared_ptr<const T> find(uint32_t id)
+  {
+    auto it = entries_.find(id);
+    if (it == entries_.end())
+    {
+      stats_.misses++;
+      return nullptr;
+    }
+
+    stats_.hits++;
+    touch(it->second);
+    return it->second.value;
+  }
+
+  /*!
+   * \brief Cache a row, replacing any entry with the same ID
+   * \return The pinned row. It stays valid even if it is evicted right away
+   *         because it does not fit the limits.
+   */
+  std::shared_ptr<const T> insert(uint32_t id, T&& value)
+  {
+    erase(id);
+
+    auto pinned = std::make_shared<const T>(std::move(value));
+    const std::size_t bytes = sizeof(T) + dynamicMemberSize(*pinned);
+
+    // New entries are the most recently used for LRU and sit just behind
+    // the hand for CLOCK, so they survive a full sweep
+    auto position = policy_ == CachePolicy::Clock
+                      ? order_.insert(hand_, id)
+                      : order_.insert(order_.begin(), id);
+
+    entries_.emplace(id, Entry{pinned, position, bytes, false});
+    stats_.bytes += bytes;
+
+    evictToFit();
+    return pinned;
+  }
+
+  /*!
+   * \brief Drop the entry with the given ID, if it is cached
+   */
+  void erase(uint32_t id)
+  {
+    auto it = entries_.find(id);
+    if (it != entries_.end())
+    {
+      removeEntry(it);
+    }
+  }
+
+  /*!
+   * \brief Drop every entry. Counters are kept.
+   */
+  void clear()
+  {
+    entries_.clear();
+    order_.clear();
+    hand_ = order_.end();
+    stats_.bytes = 0;
+  }
+
+  /*!
+   * \brief Get the hit, miss and eviction counters and the current size
+   */
+  CacheStats stats() const
+  {
+    CacheStats stats = stats_;
+    stats.entries = entries_.size();
+    return stats;
+  }
+
+private:
+  //! A cached row and its bookkeeping
+  struct Entry
+  {
+    //!< The cached row, shared with the callers that pinned it
+    std::shared_ptr<const T> value;
+
+    //!< The entry's position in order_
+    std::list<uint32_t>::iterator position;
+
+    //!< The estimated memory held by the row
+    std::size_t bytes;
+
+    //!< CLOCK reference flag, set by hits
+    bool referenced;
+  };
+
+  /*!
+   * \brief Record a hit on an entry for the eviction policy
+   */
+  void touch(Entry& entry)
+  {
+    if (policy_ == CachePolicy::LRU)
+    {
+      order_.splice(order_.begin(), order_, entry.position);
+    }
+    else if (policy_ == CachePolicy::Clock)
+    {
+      entry.referenced = true;
+    }
+  }
+
+  /*!
+   * \brief Check whether the cache is within its limits
+   */
+  bool fits() const
+  {
+    return (maxEntries_ == 0 || entries_.size() <= maxEntries_) &&
+           (maxBytes_ == 0 || stats_.bytes <= maxBytes_);
+  }
+
+  /*!
+   * \brief Evict entries until the cache is within its limits
+   */
+  void evictToFit()
+  {
+    if (policy_ == CachePolicy::Unbounded)
+    {
+      return;
+    }
+
+    while (!entries_.empty() && !fits())
+    {
+      removeEntry(entries_.find(selectVictim()));
+      stats_.evictions++;
+    }
+  }
+
+  /*!
+   * \brief Pick the ID of the entry to evict next
+   */
+  uint32_t selectVictim()
+  {
+    if (policy_ == CachePolicy::LRU)
+    {
+      return order_.back();
+    }
+
+    // Sweep the hand, giving referenced entries a second chance. This ends
+    // after at most one full turn because every visit clears a flag.
+    while (true)
+    {
+      if (hand_ == order_.end())
+      {
+        hand_ = order_.begin();
+      }
+
+      Entry& entry = entries_.find(*hand_)->second;
+      if (!entry.referenced)
+      {
+        return *hand_;
+      }
+
+      entry.referenced = false;
+      ++hand_;
+    }
+  }
+
+  /*!
+   * \brief Unlink an entry from the cache
+   */
+  void removeEntry(typename std::unordered_map<uint32_t, Entry>::iterator it)
+  {
+    if (hand_ == it->second.position)
+    {
+      ++hand_;
+    }
+
+    order_.erase(it->second.position);
+    stats_.bytes -= it->second.bytes;
+    entries_.erase(it);
+  }
+
+  //! The cached entries, keyed by row ID
+  std::unordered_map<uint32_t, Entry> entries_;
+
+  //! Entry IDs, most recently used first for LRU, the clock ring for CLOCK
+  std::list<uint32_t> order_;
+
+  //! The CLOCK hand, the next entry considered for eviction
+  std::list<uint32_t>::iterator hand_;
+
+  //! The eviction policy
+  CachePolicy policy_;
+
+  //! The maximum number of entries (zero means no limit)
+  std::size_t maxEntries_;
+
+  //! The maximum estimated size in bytes (zero means no limit)
+  std::size_t maxBytes_;
+
+  //! The hit, miss and eviction counters and the current size
+  CacheStats stats_;
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_SELECT_CACHE_HPP
@@ -0,0 +1,121 @@
+#include "cpp_sqlite/src/cpp_sqlite/DBSlowQueryLog.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <utility>
+
+namespace cpp_sqlite
+{
+
+SlowQueryLog::SlowQueryLog(std::chrono::nanoseconds threshold,
+                           std::size_t capacity)
+  : thresholdNanos_{threshold.count()},
+    mutex_{},
+    ring_{},
+    capacity_{std::max<std::size_t>(capacity, 1)},
+    next_{0},
+    totalCount_{0}
+{
+}
+
+void SlowQueryLog::configure(std::chrono::nanoseconds threshold,
+                             std::size_t capacity)
+{
+  thresholdNanos_.store(threshold.count(), std::memory_order_relaxed);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  capacity = std::max<std::size_t>(capacity, 1);
+  if (capacity == capacity_)
+  {
+    return;
+  }
+
+  // Put the entries in order, oldest first, then drop the oldest ones
+  std::rotate(ring_.begin(), ring_.begin() + next_, ring_.end());
+  if (ring_.size() > capacity)
+  {
+    ring_.erase(ring_.begin(), ring_.end() - capacity);
+  }
+  capacity_ = capacity;
+  next_ = 0;
+}
+
+void SlowQueryLog::record(SlowQuery query)
+{
+  if (query.sql.size() > kMaxSQLLength)
+  {
+    query.sql.resize(kMaxSQLLength);
+    query.sql += "...";
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  ++totalCount_;
+
+  if (ring_.size() < capacity_)
+  {
+    ring_.push_back(std::move(query));
+    return;
+  }
+
+  ring_[next_] = std::move(query);
+  next_ = (next_ + 1) % capacity_;
+}
+
+std::vector<SlowQuery> SlowQueryLog::entries() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::vector<SlowQuery> result;
+  result.reserve(ring_.size());
+  result.insert(result.end(), ring_.begin() + next_, ring_.end());
+  result.insert(result.end(), ring_.begin(), ring_.begin() + next_);
+  return result;
+}
+
+uint64_t SlowQueryLog::totalCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return totalCount_;
+}
+
+void SlowQueryLog::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  ring_.clear();
+  next_ = 0;
+}
+
+std::string SlowQueryLog::dump() const
+{
+  std::string out;
+  for (const auto& query : entries())
+  {
+    std::array<char, 32> buffer{};
+    const double millis =
+      std::chrono::duration<double, std::milli>(query.duration).count();
+    const auto result = std::to_chars(buffer.data(),
+                                      buffer.data() + buffer.size(),
+                                      millis,
+                                      std::chars_format::fixed,
+                                      3);
+    out.append(buffer.data(), result.ptr);
+    out += " ms";
+
+    if (!query.table.empty())
+    {
+      out += " [";
+      out += query.table;
+      out += ' ';
+      out += query.statement;
+      out += ']';
+    }
+
+    out += ' ';
+    out += query.sql;
+    out += '\n';
+  }
+  return out;
+}
+
+}  // namespace cpp_sqlite
@@ -0,0 +1,122 @@
+#ifndef DB_SLOW_QUERY_LOG_HPP
+#define DB_SLOW_QUERY_LOG_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cpp_sqlite
+{
+
+/*!
+ * \brief A statement that took longer than the slow query threshold
+ */
+struct SlowQuery
+{
+  //! The SQL with the bound parameter values filled in, truncated to
+  //! SlowQueryLog::kMaxSQLLength characters
+  std::string sql;
+
+  //! How long the statement ran, as measured by SQLite
+  std::chrono::nanoseconds duration{0};
+
+  //! The table of the DAO that owns the statement, or empty if the
+  //! statement does not belong to a DAO
+  std::string table;
+
+  //! Which of the DAO's statements it was, e.g. "SELECT BY ID"
+  std::string statement;
+};
+
+/*!
+ * \brief A bounded ring of the most recent slow statements
+ *
+ * Once the ring is full, every new entry replaces the oldest one. Safe to
+ * use from any thread.
+ */
+class SlowQueryLog
+{
+public:
+  //! Longer SQL is cut off, so that multi-row statements stay bounded
+  static constexpr std::size_t kMaxSQLLength = 4096;
+
+  /*!
+   * \brief Create an empty log
+   * \param threshold Statements that take at least this long are kept
+   * \param capacity The number of entries kept (at least one)
+   */
+  SlowQueryLog(std::chrono::nanoseconds threshold, std::size_t capacity);
+
+  /*!
+   * \brief Change the threshold and the capacity
+   *
+   * Shrinking the ring keeps the most recent entries.
+   */
+  void configure(std::chrono::nanoseconds threshold, std::size_t capacity);
+
+  /*!
+   * \brief Check whether a statement is slow enough to be kept
+   */
+  bool isSlow(int64_t nanos) const
+  {
+    return nanos >= thresholdNanos_.load(std::memory_order_relaxed);
+  }
+
+  /*!
+   * \brief Add an entry, replacing the oldest one if the ring is full
+   */
+  void record(SlowQuery query);
+
+  /*!
+   * \brief Copy the entries, from oldest to newest
+   */
+  std::vector<SlowQuery> entries() const;
+
+  /*!
+   * \brief Get the number of slow statements seen, including those that
+   *        have been replaced since
+   */
+  uint64_t totalCount() const;
+
+  /*!
+   * \brief Drop every entry
+   */
+  void clear();
+
+  /*!
+   * \brief Format the entries, from oldest to newest, one per line
+   *
+   * Each line holds the duration in milliseconds, the table and statement
+   * (when known) and the expanded SQL.
+   */
+  std::string dump() const;
+
+private:
+  //! Statements that take at least this many nanoseconds are kept
+  std::atomic<int64_t> thresholdNanos_;
+
+  //! Guards the ring
+  mutable std::mutex mutex_;
+
+  //! The entries. Holds up to capacity_ entries, the oldest at next_ once
+  //! it is full.
+  std::vector<SlowQuery> ring_;
+
+  //! The maximum number of entries
+  std::size_t capacity_;
+
+  //! Where the next entry goes once the ring is full
+  std::size_t next_;
+
+  //! The number of entries ever recorded
+  uint64_t totalCount_;
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_SLOW_QUERY_LOG_HPP
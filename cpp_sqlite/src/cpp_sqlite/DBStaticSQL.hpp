@@ -0,0 +1,521 @@
+#ifndef DB_STATIC_SQL_HPP
+#define DB_STATIC_SQL_HPP
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include <boost/describe.hpp>
+#include <boost/mp11.hpp>
+
+#include "cpp_sqlite/src/cpp_sqlite/DBFixedString.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBTableName.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBTraits.hpp"
+
+namespace cpp_sqlite
+{
+
+namespace detail
+{
+
+/*!
+ * \brief Copy a string built by a constexpr function into a FixedString
+ * \tparam Build Builds the string. Called at compile time only.
+ */
+template <std::string (*Build)()>
+consteval auto makeFixedString()
+{
+  constexpr std::size_t size = Build().size();
+  return FixedString<size>{Build()};
+}
+
+/*!
+ * \brief Append the decimal digits of a number
+ */
+constexpr void appendNumber(std::string& out, std::size_t value)
+{
+  std::array<char, 20> digits{};
+  std::size_t count = 0;
+  do
+  {
+    digits[count++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+
+  while (count > 0)
+  {
+    out += digits[--count];
+  }
+}
+
+}  // namespace detail
+
+/*!
+ * \brief The SQL column type that stores a member type
+ */
+template <isSupportedDBType FieldType>
+constexpr std::string_view sqlColumnType()
+{
+  if constexpr (isIntegral<FieldType>)
+  {
+    return "INTEGER";
+  }
+  else if constexpr (floatingPoint<FieldType>)
+  {
+    return "FLOAT";
+  }
+  else if constexpr (isString<FieldType>)
+  {
+    return "TEXT";
+  }
+  else
+  {
+    return "BLOB";
+  }
+}
+
+namespace detail
+{
+
+/*!
+ * \brief Append the FOREIGN KEY clause of a `name_id` column that
+ *        references the table of T
+ */
+template <ValidTransferObject T>
+constexpr void appendForeignKey(std::string& foreignKeys, std::string_view name)
+{
+  foreignKeys += ", FOREIGN KEY (";
+  foreignKeys += name;
+  foreignKeys += "_id) REFERENCES ";
+  foreignKeys += sqlTableName<T>;
+  foreignKeys += "(id)";
+}
+
+/*!
+ * \brief Build the CREATE TABLE statement of T
+ *
+ * Repeated fields are stored in junction tables, which are created
+ * separately.
+ */
+template <ValidTransferObject T>
+constexpr std::string buildCreateTableSQL()
+{
+  std::string sql = "CREATE TABLE IF NOT EXISTS ";
+  sql += sqlTableName<T>;
+  sql += " (";
+  std::string foreignKeys;
+
+  bool first = true;
+  boost::mp11::mp_for_each<boost::describe::describe_members<
+    T,
+    boost::describe::mod_inherited | boost::describe::mod_public>>(
+    [&](auto D)
+    {
+      using memberType = std::remove_cv_t<
+        std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+      const std::string_view name = D.name;
+
+      if constexpr (!IsRepeatedFieldTransferObject<memberType>)
+      {
+        if (!first)
+        {
+          sql += ", ";
+        }
+        first = false;
+        sql += name;
+      }
+
+      if constexpr (IsRepeatedFieldTransferObject<memberType>)
+      {
+        // Stored in a junction table
+      }
+      else if constexpr (IsForeignKey<memberType>)
+      {
+        sql += "_id INTEGER";
+        appendForeignKey<ForeignKeyType<memberType>>(foreignKeys, name);
+      }
+      else if constexpr (ValidTransferObject<memberType>)
+      {
+        // The field is stored as the ID of the nested object's row
+        using idType = decltype(std::declval<memberType>().id);
+        sql += "_id ";
+        sql += sqlColumnType<idType>();
+        appendForeignKey<memberType>(foreignKeys, name);
+      }
+      else if constexpr (isSupportedDBType<memberType>)
+      {
+        sql += " ";
+        sql += sqlColumnType<memberType>();
+        if (name == "id")
+        {
+          sql += " PRIMARY KEY";
+        }
+      }
+    });
+
+  sql += foreignKeys;
+  sql += ");";
+  return sql;
+}
+
+/*!
+ * \brief Build the column list of an INSERT of T, e.g. "(id, name)"
+ */
+template <ValidTransferObject T>
+constexpr std::string buildInsertColumns()
+{
+  std::string columns = "(";
+  boost::mp11::mp_for_each<boost::describe::describe_members<
+    T,
+    boost::describe::mod_inherited | boost::describe::mod_public>>(
+    [&](auto D)
+    {
+      using memberType = std::remove_cv_t<
+        std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+
+      if constexpr (!IsRepeatedFieldTransferObject<memberType>)
+      {
+        if (columns.size() > 1)
+        {
+          columns += ", ";
+        }
+        columns += D.name;
+        if constexpr (IsForeignKey<memberType> ||
+                      ValidTransferObject<memberType>)
+        {
+          columns += "_id";
+        }
+      }
+    });
+  columns += ")";
+  return columns;
+}
+
+/*!
+ * \brief Build an INSERT of T up to its VALUES groups
+ */
+template <ValidTransferObject T>
+constexpr std::string buildInsertPrefix()
+{
+  std::string sql = "INSERT INTO ";
+  sql += sqlTableName<T>;
+  sql += " ";
+  sql += buildInsertColumns<T>();
+  sql += " VALUES ";
+  return sql;
+}
+
+/*!
+ * \brief Build the VALUES group of one row of T, e.g. "(?, ?)"
+ */
+template <ValidTransferObject T>
+constexpr std::string buildInsertValues()
+{
+  std::string values = "(";
+  std::size_t columns = 0;
+  boost::mp11::mp_for_each<boost::describe::describe_members<
+    T,
+    boost::describe::mod_inherited | boost::describe::mod_public>>(
+    [&](auto D)
+    {
+      using memberType = std::remove_cv_t<
+        std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+
+      if constexpr (!IsRepeatedFieldTransferObject<memberType>)
+      {
+        values += columns++ == 0 ? "?" : ", ?";
+      }
+    });
+  values += ")";
+  return values;
+}
+
+template <ValidTransferObject T>
+constexpr std::string buildInsertSQL()
+{
+  return buildInsertPrefix<T>() + buildInsertValues<T>() + ";";
+}
+
+/*!
+ * \brief Add the columns of T and the LEFT JOINs of its nested transfer
+ *        objects to a SELECT
+ *
+ * The columns of a nested object directly follow the `_id` column that
+ * references it, so one result row holds the whole nested-object tree.
+ * Repeated fields are not part of the row.
+ *
+ * \param alias The alias of T's table in the query
+ * \param aliasCount The number of table aliases in use. Advanced for
+ *        every joined table.
+ * \param columns The comma separated column list to extend
+ * \param joins The join clauses to extend
+ */
+template <ValidTransferObject T>
+constexpr void appendSelectSource(const std::string& alias,
+                                  std::size_t& aliasCount,
+                                  std::string& columns,
+                                  std::string& joins)
+{
+  boost::mp11::mp_for_each<boost::describe::describe_members<
+    T,
+    boost::describe::mod_inherited | boost::describe::mod_public>>(
+    [&](auto D)
+    {
+      using memberType = std::remove_cv_t<
+        std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+
+      if constexpr (!IsRepeatedFieldTransferObject<memberType>)
+      {
+        if (!columns.empty())
+        {
+          columns += ", ";
+        }
+        columns += alias;
+        columns += ".";
+        columns += D.name;
+      }
+
+      if constexpr (IsRepeatedFieldTransferObject<memberType>)
+      {
+        // Stored in a junction table
+      }
+      else if constexpr (IsForeignKey<memberType>)
+      {
+        // ForeignKey fields are stored as "_id" columns and loaded lazily
+        columns += "_id";
+      }
+      else if constexpr (ValidTransferObject<memberType>)
+      {
+        columns += "_id";
+
+        std::string nestedAlias = "t";
+        appendNumber(nestedAlias, aliasCount++);
+
+        joins += " LEFT JOIN ";
+        joins += sqlTableName<memberType>;
+        joins += " " + nestedAlias + " ON " + nestedAlias + ".id = " + alias +
+                 ".";
+        joins += D.name;
+        joins += "_id";
+
+        appendSelectSource<memberType>(nestedAlias, aliasCount, columns, joins);
+      }
+    });
+}
+
+/*!
+ * \brief Build the SELECT of T without a WHERE clause
+ */
+template <ValidTransferObject T>
+constexpr std::string buildSelectSQL()
+{
+  std::string columns;
+  std::string joins;
+  std::size_t aliasCount = 1;
+  appendSelectSource<T>("t0", aliasCount, columns, joins);
+
+  std::string sql = "SELECT " + columns + " FROM ";
+  sql += sqlTableName<T>;
+  sql += " t0" + joins;
+  return sql;
+}
+
+template <ValidTransferObject T>
+constexpr std::string buildSelectAllSQL()
+{
+  return buildSelectSQL<T>() + ";";
+}
+
+template <ValidTransferObject T>
+constexpr std::string buildSelectByIdSQL()
+{
+  return buildSelectSQL<T>() + " WHERE t0.id = ?;";
+}
+
+template <ValidTransferObject T>
+constexpr std::string buildSelectByIdsPrefix()
+{
+  return buildSelectSQL<T>() + " WHERE t0.id IN (";
+}
+
+/*!
+ * \brief Build the name of the junction table linking Parent to Child
+ */
+template <ValidTransferObject Parent, ValidTransferObject Child>
+constexpr std::string buildJunctionTableName()
+{
+  std::string name{sqlTableName<Parent>};
+  name += "_";
+  name += sqlTableName<Child>;
+  return name;
+}
+
+/*!
+ * \brief Build the CREATE TABLE statement of the junction table linking
+ *        Parent to Child
+ *
+ * Junction tables are WITHOUT ROWID tables keyed by (parent_id,
+ * child_id), so the children of a parent are found with an index range
+ * scan.
+ */
+template <ValidTransferObject Parent, ValidTransferObject Child>
+constexpr std::string buildJunctionCreateTableSQL()
+{
+  std::string parentColumn{sqlTableName<Parent>};
+  parentColumn += "_id";
+  std::string childColumn{sqlTableName<Child>};
+  childColumn += "_id";
+
+  return "CREATE TABLE IF NOT EXISTS " +
+         buildJunctionTableName<Parent, Child>() + "(" + parentColumn +
+         " INTEGER NOT NULL, " + childColumn +
+         " INTEGER NOT NULL, PRIMARY KEY (" + parentColumn + ", " +
+         childColumn + ")) WITHOUT ROWID;";
+}
+
+/*!
+ * \brief Build the CREATE INDEX statement of the index that finds the
+ *        parents of a Child row
+ */
+template <ValidTransferObject Parent, ValidTransferObject Child>
+constexpr std::string buildJunctionReverseIndexSQL()
+{
+  const std::string junctionTable = buildJunctionTableName<Parent, Child>();
+  std::string sql = "CREATE INDEX IF NOT EXISTS " + junctionTable +
+                    "_reverse ON " + junctionTable + "(";
+  sql += sqlTableName<Child>;
+  sql += "_id);";
+  return sql;
+}
+
+template <ValidTransferObject Parent, ValidTransferObject Child>
+constexpr std::string buildJunctionInsertSQL()
+{
+  std::string sql = "INSERT INTO " + buildJunctionTableName<Parent, Child>();
+  sql += "(";
+  sql += sqlTableName<Parent>;
+  sql += "_id, ";
+  sql += sqlTableName<Child>;
+  sql += "_id) VALUES (?, ?);";
+  return sql;
+}
+
+/*!
+ * \brief Build the SELECT of the Child rows of parent rows, up to the
+ *        opening parenthesis of the IN list of parent IDs
+ */
+template <ValidTransferObject Parent, ValidTransferObject Child>
+constexpr std::string buildJunctionSelectPrefix()
+{
+  std::string columns;
+  std::string joins;
+  std::size_t aliasCount = 1;
+  appendSelectSource<Child>("t0", aliasCount, columns, joins);
+
+  std::string sql = "SELECT j.";
+  sql += sqlTableName<Parent>;
+  sql += "_id, " + columns + " FROM " +
+         buildJunctionTableName<Parent, Child>() + " j JOIN ";
+  sql += sqlTableName<Child>;
+  sql += " t0 ON t0.id = j.";
+  sql += sqlTableName<Child>;
+  sql += "_id" + joins + " WHERE j.";
+  sql += sqlTableName<Parent>;
+  sql += "_id IN (";
+  return sql;
+}
+
+/*!
+ * \brief Build the end of the SELECT of the Child rows of parent rows,
+ *        from the closing parenthesis of the IN list of parent IDs
+ *
+ * Child IDs are assigned in insertion order, so ordering by them returns
+ * the children of a parent in the order they were stored, whatever plan
+ * SQLite picks for the join.
+ */
+template <ValidTransferObject Parent, ValidTransferObject Child>
+constexpr std::string buildJunctionSelectSuffix()
+{
+  std::string sql = ") ORDER BY j.";
+  sql += sqlTableName<Parent>;
+  sql += "_id, j.";
+  sql += sqlTableName<Child>;
+  sql += "_id;";
+  return sql;
+}
+
+}  // namespace detail
+
+/*!
+ * \brief The SQL statements of the table of T, generated at compile time
+ *
+ * Everything is derived from the BOOST_DESCRIBE_STRUCT of T, so opening a
+ * DAO does no string building. Statements whose size is only known at
+ * run time (multi-row inserts and IN lists) are assembled from the
+ * prefixes here.
+ *
+ * \tparam T The transfer object stored in the table
+ */
+template <ValidTransferObject T>
+struct TableSQL
+{
+  static constexpr auto createTable =
+    detail::makeFixedString<&detail::buildCreateTableSQL<T>>();
+
+  static constexpr auto insert =
+    detail::makeFixedString<&detail::buildInsertSQL<T>>();
+
+  //! "INSERT INTO T (...) VALUES ", followed by one insertValues per row
+  static constexpr auto insertPrefix =
+    detail::makeFixedString<&detail::buildInsertPrefix<T>>();
+
+  static constexpr auto insertValues =
+    detail::makeFixedString<&detail::buildInsertValues<T>>();
+
+  static constexpr auto selectAll =
+    detail::makeFixedString<&detail::buildSelectAllSQL<T>>();
+
+  static constexpr auto selectById =
+    detail::makeFixedString<&detail::buildSelectByIdSQL<T>>();
+
+  //! The SELECT up to the opening parenthesis of an IN list of IDs
+  static constexpr auto selectByIdsPrefix =
+    detail::makeFixedString<&detail::buildSelectByIdsPrefix<T>>();
+};
+
+/*!
+ * \brief The SQL statements of the junction table that stores the Child
+ *        rows of a repeated field of Parent
+ */
+template <ValidTransferObject Parent, ValidTransferObject Child>
+struct JunctionSQL
+{
+  static constexpr auto tableName =
+    detail::makeFixedString<&detail::buildJunctionTableName<Parent, Child>>();
+
+  static constexpr auto createTable = detail::makeFixedString<
+    &detail::buildJunctionCreateTableSQL<Parent, Child>>();
+
+  static constexpr auto createReverseIndex = detail::makeFixedString<
+    &detail::buildJunctionReverseIndexSQL<Parent, Child>>();
+
+  static constexpr auto insert =
+    detail::makeFixedString<&detail::buildJunctionInsertSQL<Parent, Child>>();
+
+  //! The child SELECT up to the opening parenthesis of the IN list of
+  //! parent IDs. Each row holds the parent ID followed by the child's
+  //! columns.
+  static constexpr auto selectPrefix = detail::makeFixedString<
+    &detail::buildJunctionSelectPrefix<Parent, Child>>();
+
+  //! The end of the child SELECT, from the closing parenthesis of the IN
+  //! list. Orders the children of each parent by insertion.
+  static constexpr auto selectSuffix = detail::makeFixedString<
+    &detail::buildJunctionSelectSuffix<Parent, Child>>();
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_STATIC_SQL_HPP
@@ -0,0 +1,141 @@
+#ifndef DB_TABLE_NAME_HPP
+#define DB_TABLE_NAME_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <string_view>
+
+#include "cpp_sqlite/src/cpp_sqlite/DBFixedString.hpp"
+
+/*!
+ * \brief Store a transfer object in a table with the given name instead of
+ *        its type name
+ *
+ * Place it next to BOOST_DESCRIBE_STRUCT, in the namespace of the type:
+ * \code
+ * BOOST_DESCRIBE_STRUCT(Vertex, (cpp_sqlite::BaseTransferObject), (x, y));
+ * CPP_SQLITE_TABLE_NAME(Vertex, "vertices");
+ * \endcode
+ *
+ * The name is used unquoted in SQL, so it must be a plain identifier.
+ */
+#define CPP_SQLITE_TABLE_NAME(Type, Name)                                  \
+  [[maybe_unused]] constexpr std::string_view cpp_sqlite_table_name(Type*) \
+  {                                                                        \
+    return Name;                                                           \
+  }
+
+namespace cpp_sqlite
+{
+
+/*!
+ * \brief Satisfied by types whose table name is set with
+ *        CPP_SQLITE_TABLE_NAME
+ */
+template <typename T>
+concept HasTableNameOverride = requires(T* type) {
+  { cpp_sqlite_table_name(type) } -> std::convertible_to<std::string_view>;
+};
+
+namespace detail
+{
+
+/*!
+ * \brief The qualified name of T as the compiler spells it
+ */
+template <typename T>
+consteval std::string_view rawTypeName()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  // "... __cdecl cpp_sqlite::detail::rawTypeName<struct ns::T>(void)"
+  std::string_view name = __FUNCSIG__;
+  name.remove_prefix(name.find("rawTypeName<") + 12);
+  name.remove_suffix(name.size() - name.rfind(">(void)"));
+  for (std::string_view keyword : {"struct ", "class ", "enum "})
+  {
+    if (name.starts_with(keyword))
+    {
+      name.remove_prefix(keyword.size());
+    }
+  }
+  return name;
+#else
+  // GCC: "... rawTypeName() [with T = ns::T; ...]"
+  // Clang: "... rawTypeName() [T = ns::T]"
+  std::string_view name = __PRETTY_FUNCTION__;
+  name.remove_prefix(name.find("T = ") + 4);
+  return name.substr(0, name.find_first_of(";]"));
+#endif
+}
+
+/*!
+ * \brief The name of T without its namespace
+ */
+template <typename T>
+consteval std::string_view unqualifiedTypeName()
+{
+  constexpr std::string_view name = rawTypeName<T>();
+  constexpr std::size_t pos = name.rfind("::");
+  return pos == std::string_view::npos ? name : name.substr(pos + 2);
+}
+
+/*!
+ * \brief Check that a name can be used unquoted as an SQL identifier
+ */
+consteval bool isPlainIdentifier(std::string_view name)
+{
+  if (name.empty() || (name.front() >= '0' && name.front() <= '9'))
+  {
+    return false;
+  }
+
+  return std::ranges::all_of(name,
+                             [](char c)
+                             {
+                               return (c >= 'a' && c <= 'z') ||
+                                      (c >= 'A' && c <= 'Z') ||
+                                      (c >= '0' && c <= '9') || c == '_';
+                             });
+}
+
+/*!
+ * \brief The name of the table that stores T
+ */
+template <typename T>
+consteval std::string_view tableNameOf()
+{
+  if constexpr (HasTableNameOverride<T>)
+  {
+    constexpr std::string_view name =
+      cpp_sqlite_table_name(static_cast<T*>(nullptr));
+    static_assert(isPlainIdentifier(name),
+                  "CPP_SQLITE_TABLE_NAME must be a plain SQL identifier");
+    return name;
+  }
+  else
+  {
+    return unqualifiedTypeName<T>();
+  }
+}
+
+}  // namespace detail
+
+//! Storage for sqlTableName, so that it does not point into compiler
+//! generated function names
+template <typename T>
+inline constexpr FixedString<detail::tableNameOf<T>().size()> tableNameStorage{
+  detail::tableNameOf<T>()};
+
+/*!
+ * \brief The name of the table that stores T
+ *
+ * The name set with CPP_SQLITE_TABLE_NAME, or else the type name without
+ * its namespace. Computed at compile time.
+ */
+template <typename T>
+inline constexpr std::string_view sqlTableName = tableNameStorage<T>.view();
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_TABLE_NAME_HPP
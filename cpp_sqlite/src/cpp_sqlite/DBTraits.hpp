@@ -2,9 +2,12 @@
 #define DB_TRAITS_HPP
 
 #include <concepts>
+#include <cstddef>
 #include <type_traits>
 #include <vector>
 
+#include <boost/describe.hpp>
+#include <boost/mp11.hpp>
 #include "sqlite3.h"
 
 #include "cpp_sqlite/src/cpp_sqlite/DBBaseTransferObject.hpp"
@@ -154,6 +157,100 @@ template <typename T>
 concept isSupportedDBType = isIntegral<T> || floatingPoint<T> || isString<T> ||
                             isBlob<T> || ValidTransferObject<T>;
 
+/*!
+ * \brief Check whether every member of T maps directly onto a column
+ *
+ * A flat transfer object has no nested transfer objects and no repeated
+ * fields, so inserting a row never touches another table. Rows of flat
+ * types can therefore be written with multi-row INSERT statements.
+ */
+template <typename T>
+consteval bool hasOnlyColumnMembers()
+{
+  bool flat = true;
+  boost::mp11::mp_for_each<boost::describe::describe_members<
+    T,
+    boost::describe::mod_inherited | boost::describe::mod_public>>(
+    [&](auto D)
+    {
+      using memberType = std::remove_cv_t<
+        std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+
+      if constexpr (IsRepeatedFieldTransferObject<memberType> ||
+                    ValidTransferObject<memberType>)
+      {
+        flat = false;
+      }
+    });
+  return flat;
+}
+
+template <typename T>
+concept FlatTransferObject =
+  ValidTransferObject<T> && hasOnlyColumnMembers<T>();
+
+/*!
+ * \brief Check whether T, or any transfer object nested in T, has a
+ *        repeated field
+ */
+template <typename T>
+consteval bool hasRepeatedFields()
+{
+  bool found = false;
+  boost::mp11::mp_for_each<boost::describe::describe_members<
+    T,
+    boost::describe::mod_inherited | boost::describe::mod_public>>(
+    [&](auto D)
+    {
+      using memberType = std::remove_cv_t<
+        std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+
+      if constexpr (IsRepeatedFieldTransferObject<memberType>)
+      {
+        found = true;
+      }
+      else if constexpr (ValidTransferObject<memberType>)
+      {
+        found = found || hasRepeatedFields<memberType>();
+      }
+    });
+  return found;
+}
+
+/*!
+ * \brief The number of columns a SELECT of T reads
+ *
+ * Nested transfer objects are joined into the same row, so their columns
+ * are counted as well.
+ */
+template <typename T>
+consteval std::size_t selectColumnCount()
+{
+  std::size_t count = 0;
+  boost::mp11::mp_for_each<boost::describe::describe_members<
+    T,
+    boost::describe::mod_inherited | boost::describe::mod_public>>(
+    [&](auto D)
+    {
+      using memberType = std::remove_cv_t<
+        std::remove_reference_t<decltype(std::declval<T>().*D.pointer)>>;
+
+      if constexpr (IsRepeatedFieldTransferObject<memberType>)
+      {
+        // Stored in a junction table
+      }
+      else if constexpr (ValidTransferObject<memberType>)
+      {
+        count += 1 + selectColumnCount<memberType>();
+      }
+      else if constexpr (IsForeignKey<memberType> ||
+                         isSupportedDBType<memberType>)
+      {
+        ++count;
+      }
+    });
+  return count;
+}
 
 }  // namespace cpp_sqlite
 
@@ -0,0 +1,144 @@
+#include "cpp_sqlite/src/cpp_sqlite/DBTransaction.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "cpp_sqlite/src/cpp_sqlite/DBDatabase.hpp"
+
+namespace cpp_sqlite
+{
+
+namespace
+{
+//! Counter used to give every savepoint a unique name
+std::atomic<uint64_t> savepointCounter{0};
+}  // namespace
+
+Transaction::Transaction(Database& database,
+                         std::shared_ptr<spdlog::logger> pLogger)
+  : database_{database},
+    db_{database.getRawDB()},
+    savepointName_{},
+    active_{false},
+    pLogger_{pLogger}
+{
+  // sqlite3_get_autocommit returns non-zero when no transaction is open
+  if (sqlite3_get_autocommit(&db_) != 0)
+  {
+    active_ = execute("BEGIN;");
+    if (active_)
+    {
+      database_.setTransactionOwner(std::this_thread::get_id());
+    }
+  }
+  else
+  {
+    savepointName_ = "cpp_sqlite_sp_" + std::to_string(++savepointCounter);
+    active_ = execute("SAVEPOINT " + savepointName_ + ";");
+  }
+}
+
+Transaction::~Transaction()
+{
+  if (active_)
+  {
+    rollback();
+  }
+}
+
+bool Transaction::commit()
+{
+  if (!active_)
+  {
+    return false;
+  }
+
+  bool success = savepointName_.empty()
+                   ? execute("COMMIT;")
+                   : execute("RELEASE " + savepointName_ + ";");
+
+  if (!success)
+  {
+    rollback();
+    return false;
+  }
+
+  active_ = false;
+  if (savepointName_.empty())
+  {
+    database_.forgetTransactionWrites();
+    database_.setTransactionOwner({});
+  }
+  return true;
+}
+
+void Transaction::rollback()
+{
+  if (!active_)
+  {
+    return;
+  }
+
+  if (savepointName_.empty())
+  {
+    // A failed statement can already have ended the transaction, in which
+    // case there is nothing left to roll back.
+    if (sqlite3_get_autocommit(&db_) == 0)
+    {
+      execute("ROLLBACK;");
+    }
+  }
+  else
+  {
+    // Likewise the savepoint is gone if the whole transaction was ended
+    if (sqlite3_get_autocommit(&db_) == 0)
+    {
+      // ROLLBACK TO leaves the savepoint on the stack, so release it too
+      execute("ROLLBACK TO " + savepointName_ + ";");
+      execute("RELEASE " + savepointName_ + ";");
+
+      // Unlike ROLLBACK, this does not invoke the rollback hook
+      database_.clearTransactionCaches();
+    }
+  }
+
+  active_ = false;
+  if (savepointName_.empty())
+  {
+    database_.setTransactionOwner({});
+  }
+}
+
+bool Transaction::isActive() const
+{
+  return active_;
+}
+
+bool Transaction::isSavepoint() const
+{
+  return !savepointName_.empty();
+}
+
+bool Transaction::execute(const std::string& sql)
+{
+  char* errMsg = nullptr;
+  int result = sqlite3_exec(&db_, sql.c_str(), nullptr, nullptr, &errMsg);
+
+  if (result != SQLITE_OK)
+  {
+    LOG_SAFE(pLogger_,
+             spdlog::level::err,
+             "Transaction statement '{}' failed with code {}: {}",
+             sql,
+             result,
+             errMsg ? errMsg : "unknown error");
+    sqlite3_free(errMsg);
+    return false;
+  }
+
+  LOG_SAFE(pLogger_, spdlog::level::trace, "Executed: {}", sql);
+  return true;
+}
+
+}  // namespace cpp_sqlite
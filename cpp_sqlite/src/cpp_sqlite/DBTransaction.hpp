@@ -0,0 +1,104 @@
+#ifndef DB_TRANSACTION_HPP
+#define DB_TRANSACTION_HPP
+
+#include <memory>
+#include <string>
+
+#include "sqlite3.h"
+
+#include "cpp_sqlite/src/utils/Logger.hpp"
+
+namespace cpp_sqlite
+{
+
+class Database;
+
+/*!
+ * \brief RAII scope for a SQLite transaction
+ *
+ * If the connection is in autocommit mode the scope opens a top-level
+ * transaction with BEGIN. If a transaction is already open (for example
+ * because the caller issued BEGIN themselves) the scope opens a SAVEPOINT
+ * instead so that it nests correctly inside the outer transaction.
+ *
+ * A scope that is destroyed without calling commit() is rolled back.
+ *
+ * Example:
+ * \code
+ * {
+ *   cpp_sqlite::Transaction transaction{db};
+ *   dao.insert(first);
+ *   dao.insert(second);
+ *   transaction.commit();
+ * }
+ * \endcode
+ */
+class Transaction
+{
+public:
+  /*!
+   * \brief Open a transaction (or savepoint) on the given database
+   * \param database The database to open the transaction on
+   * \param pLogger Optional logger for reporting failures
+   */
+  explicit Transaction(Database& database,
+                       std::shared_ptr<spdlog::logger> pLogger = nullptr);
+
+  /*!
+   * \brief Roll back the transaction if it was not committed
+   */
+  ~Transaction();
+
+  Transaction(const Transaction&) = delete;
+  Transaction& operator=(const Transaction&) = delete;
+  Transaction(Transaction&&) = delete;
+  Transaction& operator=(Transaction&&) = delete;
+
+  /*!
+   * \brief Commit the transaction (or release the savepoint)
+   * \return True if the commit succeeded. On failure the transaction
+   *         is rolled back.
+   */
+  bool commit();
+
+  /*!
+   * \brief Roll back the transaction (or roll back to the savepoint)
+   */
+  void rollback();
+
+  /*!
+   * \brief Check whether the transaction is open and not yet finished
+   */
+  bool isActive() const;
+
+  /*!
+   * \brief Check whether this scope is a nested SAVEPOINT
+   */
+  bool isSavepoint() const;
+
+private:
+  /*!
+   * \brief Execute a transaction control statement
+   * \return True if the statement succeeded
+   */
+  bool execute(const std::string& sql);
+
+  //! The database the transaction is opened on
+  Database& database_;
+
+  //! The raw connection the transaction is opened on
+  sqlite3& db_;
+
+  //! Name of the savepoint, empty for a top-level transaction
+  std::string savepointName_;
+
+  //! Whether the transaction is currently open
+  bool active_;
+
+  //! The local logger
+  std::shared_ptr<spdlog::logger> pLogger_;
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_TRANSACTION_HPP
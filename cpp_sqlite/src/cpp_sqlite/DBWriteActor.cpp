@@ -0,0 +1,180 @@
+#include "cpp_sqlite/src/cpp_sqlite/DBWriteActor.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <iterator>
+
+#include "cpp_sqlite/src/cpp_sqlite/DBDatabase.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBTransaction.hpp"
+
+namespace cpp_sqlite
+{
+
+WriteActor::WriteActor(Database& database,
+                       std::size_t maxCommandsPerTransaction,
+                       std::shared_ptr<spdlog::logger> pLogger)
+  : db_{database},
+    maxCommandsPerTransaction_{std::max<std::size_t>(maxCommandsPerTransaction,
+                                                     1)},
+    mutex_{},
+    wakeActor_{},
+    queue_{},
+    batch_{},
+    stopping_{false},
+    pLogger_{pLogger},
+    thread_{&WriteActor::run, this}
+{
+  LOG_SAFE(pLogger_,
+           spdlog::level::debug,
+           "Started write actor (max commands per transaction: {})",
+           maxCommandsPerTransaction_);
+}
+
+WriteActor::~WriteActor()
+{
+  stop();
+}
+
+std::future<bool> WriteActor::submit(Command command)
+{
+  PendingCommand pending{std::move(command), {}, nullptr};
+  std::future<bool> result = pending.done.get_future();
+
+  if (!enqueue(pending))
+  {
+    pending.done.set_value(false);
+  }
+
+  return result;
+}
+
+void WriteActor::submit(Command command, Completion onDone)
+{
+  PendingCommand pending{std::move(command), {}, std::move(onDone)};
+
+  if (!enqueue(pending))
+  {
+    pending.onDone(false);
+  }
+}
+
+bool WriteActor::enqueue(PendingCommand& pending)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopping_)
+    {
+      LOG_SAFE(pLogger_,
+               spdlog::level::err,
+               "Write command submitted after the write actor stopped");
+      return false;
+    }
+    queue_.push_back(std::move(pending));
+  }
+  wakeActor_.notify_one();
+
+  return true;
+}
+
+void WriteActor::stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wakeActor_.notify_one();
+
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+}
+
+bool WriteActor::isActorThread() const
+{
+  return std::this_thread::get_id() == thread_.get_id();
+}
+
+void WriteActor::run()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  while (true)
+  {
+    wakeActor_.wait(lock, [&] { return stopping_ || !queue_.empty(); });
+
+    if (queue_.empty())
+    {
+      // Only reached when stopping, after the queue has been drained
+      break;
+    }
+
+    // Everything that queued up while the previous batch ran is coalesced
+    // into the next transaction
+    const std::size_t count =
+      std::min(queue_.size(), maxCommandsPerTransaction_);
+    std::move(queue_.begin(),
+              queue_.begin() + static_cast<std::ptrdiff_t>(count),
+              std::back_inserter(batch_));
+    queue_.erase(queue_.begin(),
+                 queue_.begin() + static_cast<std::ptrdiff_t>(count));
+
+    lock.unlock();
+    executeBatch();
+    lock.lock();
+  }
+
+  LOG_SAFE(pLogger_, spdlog::level::debug, "Stopped write actor");
+}
+
+void WriteActor::executeBatch()
+{
+  std::vector<bool> succeeded(batch_.size(), false);
+  std::vector<std::exception_ptr> errors(batch_.size());
+
+  Transaction transaction{db_, pLogger_};
+
+  for (std::size_t i = 0; i < batch_.size(); ++i)
+  {
+    // A failed command only rolls back its own savepoint
+    Transaction savepoint{db_, pLogger_};
+    try
+    {
+      succeeded[i] = batch_[i].command() && savepoint.commit();
+    }
+    catch (...)
+    {
+      errors[i] = std::current_exception();
+    }
+  }
+
+  // Without an outer transaction every command committed on its own
+  const bool committed = !transaction.isActive() || transaction.commit();
+  if (!committed)
+  {
+    LOG_SAFE(pLogger_,
+             spdlog::level::err,
+             "Failed to commit a batch of {} write commands",
+             batch_.size());
+  }
+
+  for (std::size_t i = 0; i < batch_.size(); ++i)
+  {
+    if (batch_[i].onDone)
+    {
+      batch_[i].onDone(!errors[i] && committed && succeeded[i]);
+    }
+    else if (errors[i])
+    {
+      batch_[i].done.set_exception(errors[i]);
+    }
+    else
+    {
+      batch_[i].done.set_value(committed && succeeded[i]);
+    }
+  }
+
+  batch_.clear();
+}
+
+}  // namespace cpp_sqlite
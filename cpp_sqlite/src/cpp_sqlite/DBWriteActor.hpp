@@ -0,0 +1,151 @@
+#ifndef DB_WRITE_ACTOR_HPP
+#define DB_WRITE_ACTOR_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "cpp_sqlite/src/utils/Logger.hpp"
+
+namespace cpp_sqlite
+{
+
+class Database;
+
+/*!
+ * \brief A thread that owns all writes to a database connection
+ *
+ * Any thread can submit a write command. Commands run one after another
+ * on the actor thread, so writes never contend for the connection. All
+ * commands that are waiting when the actor wakes up (up to a limit) run
+ * in one transaction, so a burst of small writes pays for a single
+ * journal sync. Every command runs in its own SAVEPOINT, so a command
+ * that fails is rolled back without affecting the others in its batch.
+ */
+class WriteActor
+{
+public:
+  //! A write command. Returns true on success.
+  using Command = std::function<bool()>;
+
+  //! Receives the outcome of a command once its transaction has finished
+  using Completion = std::function<void(bool)>;
+
+  /*!
+   * \brief Start the actor thread
+   * \param database The database the commands write to
+   * \param maxCommandsPerTransaction The most commands run in one
+   *        transaction
+   * \param pLogger Optional logger
+   */
+  WriteActor(Database& database,
+             std::size_t maxCommandsPerTransaction,
+             std::shared_ptr<spdlog::logger> pLogger = nullptr);
+
+  /*!
+   * \brief Stop the actor after running every queued command
+   */
+  ~WriteActor();
+
+  WriteActor(const WriteActor&) = delete;
+  WriteActor& operator=(const WriteActor&) = delete;
+  WriteActor(WriteActor&&) = delete;
+  WriteActor& operator=(WriteActor&&) = delete;
+
+  /*!
+   * \brief Queue a command
+   * \return A future that becomes true once the command's writes are
+   *         committed, or false if the command or its transaction failed.
+   *         Commands submitted after stop() fail immediately.
+   */
+  std::future<bool> submit(Command command);
+
+  /*!
+   * \brief Queue a command whose outcome is reported through a callback
+   * \param command The command to run
+   * \param onDone Called on the actor thread with true once the command's
+   *        writes are committed, or false if the command, its transaction
+   *        or the submission failed. A command that throws reports false.
+   */
+  void submit(Command command, Completion onDone);
+
+  /*!
+   * \brief Run every queued command and join the actor thread
+   */
+  void stop();
+
+  /*!
+   * \brief Check whether the calling thread is the actor thread
+   */
+  bool isActorThread() const;
+
+private:
+  //! A queued command and the promise reporting its outcome
+  struct PendingCommand
+  {
+    //!< The command to run
+    Command command;
+
+    //!< Fulfilled once the command's transaction has finished, unless
+    //!< onDone is set
+    std::promise<bool> done;
+
+    //!< Receives the outcome instead of the promise, if set
+    Completion onDone;
+  };
+
+  /*!
+   * \brief Queue a command
+   * \return False if the actor has stopped
+   */
+  bool enqueue(PendingCommand& pending);
+
+  /*!
+   * \brief The actor thread main loop
+   */
+  void run();
+
+  /*!
+   * \brief Run the commands of batch_ in one transaction and report their
+   *        outcome
+   */
+  void executeBatch();
+
+  //! The database the commands write to
+  Database& db_;
+
+  //! The most commands run in one transaction
+  std::size_t maxCommandsPerTransaction_;
+
+  //! Guards the queue and the stop flag
+  std::mutex mutex_;
+
+  //! Wakes the actor thread
+  std::condition_variable wakeActor_;
+
+  //! Commands waiting to run
+  std::deque<PendingCommand> queue_;
+
+  //! The commands of the current transaction. Only used by the actor
+  //! thread; its capacity is reused between batches.
+  std::vector<PendingCommand> batch_;
+
+  //! Set when the actor should exit once the queue is empty
+  bool stopping_;
+
+  //! The local logger
+  std::shared_ptr<spdlog::logger> pLogger_;
+
+  //! The actor thread (declared last so it starts after the state above)
+  std::thread thread_;
+};
+
+}  // namespace cpp_sqlite
+
+#endif  // DB_WRITE_ACTOR_HPP
@@ -2,7 +2,7 @@
 
 namespace cpp_sqlite
 {
-Logger::Logger() : logger_{nullptr}
+Logger::Logger() : threadPool_{nullptr}, logger_{nullptr}
 {
   // Configure with default settings on construction
   try
@@ -18,7 +18,8 @@ Logger::Logger() : logger_{nullptr}
 
 void Logger::configure(const std::string& loggerName,
                        const std::string& logFile,
-                       spdlog::level::level_enum level)
+                       spdlog::level::level_enum level,
+                       Mode mode)
 {
   // Validate inputs
   if (loggerName.empty())
@@ -52,8 +53,25 @@ void Logger::configure(const std::string& loggerName,
 
     // Create logger with both sinks
     std::vector<spdlog::sink_ptr> sinks = {console_sink, file_sink};
-    logger_ =
-      std::make_shared<spdlog::logger>(loggerName, sinks.begin(), sinks.end());
+    if (mode == Mode::Async)
+    {
+      if (!threadPool_)
+      {
+        threadPool_ =
+          std::make_shared<spdlog::details::thread_pool>(kAsyncQueueSize, 1);
+      }
+      logger_ = std::make_shared<spdlog::async_logger>(
+        loggerName,
+        sinks.begin(),
+        sinks.end(),
+        threadPool_,
+        spdlog::async_overflow_policy::overrun_oldest);
+    }
+    else
+    {
+      logger_ = std::make_shared<spdlog::logger>(
+        loggerName, sinks.begin(), sinks.end());
+    }
 
     logger_->set_level(level);
     logger_->flush_on(spdlog::level::warn);
@@ -7,6 +7,7 @@
 #include <stdexcept>
 #include <string>
 
+#include <spdlog/async.h>
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
@@ -32,10 +33,25 @@ public:
     return instance;
   }
 
+  // How log messages reach the sinks
+  enum class Mode
+  {
+    // Messages are formatted and written on the calling thread
+    Sync,
+    // Messages are queued and written by a background thread. When the
+    // queue is full the oldest messages are dropped, so logging never
+    // blocks the caller.
+    Async
+  };
+
+  // Number of messages the queue of an asynchronous logger holds
+  static constexpr std::size_t kAsyncQueueSize = 8192;
+
   // Configure logger with file and console output
   void configure(const std::string& loggerName = "cpp_sqlite",
                  const std::string& logFile = "cpp_sqlite.log",
-                 spdlog::level::level_enum level = spdlog::level::info);
+                 spdlog::level::level_enum level = spdlog::level::info,
+                 Mode mode = Mode::Sync);
 
   // Set log level
   void setLevel(spdlog::level::level_enum level);
@@ -50,16 +66,28 @@ private:
   Logger();
   ~Logger() = default;
 
+  // Background thread of asynchronous loggers, created on first use.
+  // Declared before logger_ so that it outlives it.
+  std::shared_ptr<spdlog::details::thread_pool> threadPool_;
+
   std::shared_ptr<spdlog::logger> logger_;
 };
 
 
 }  // namespace cpp_sqlite
 
+// Lowest level that is compiled in, as one of the SPDLOG_LEVEL_* values.
+// LOG_SAFE calls below it are removed at compile time, arguments included.
+// Set through the CPP_SQLITE_ACTIVE_LOG_LEVEL CMake option.
+#ifndef CPP_SQLITE_ACTIVE_LOG_LEVEL
+#define CPP_SQLITE_ACTIVE_LOG_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+
 // Macro for safe logging with logger pointer, level, and variadic arguments
 // Usage: LOG_SAFE(pLogger, spdlog::level::info, "Message with {} args", value)
-#define LOG_SAFE(logger_ptr, level, ...)                          \
-  if ((logger_ptr) != nullptr && (logger_ptr)->should_log(level)) \
+#define LOG_SAFE(logger_ptr, level, ...)                         \
+  if (static_cast<int>(level) >= CPP_SQLITE_ACTIVE_LOG_LEVEL &&  \
+      (logger_ptr) != nullptr && (logger_ptr)->should_log(level)) \
   (logger_ptr)->log(level, __VA_ARGS__)
 
 #endif  // LOGGER_HPP
\ No newline at end of file
@@ -1,41 +1,27 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <coroutine>
+#include <fstream>
+#include <future>
+#include <optional>
+#include <ranges>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_map>
 
 #include <boost/describe.hpp>
 #include <boost/describe/class.hpp>
+#include <spdlog/sinks/null_sink.h>
 
 #include "cpp_sqlite/src/cpp_sqlite/DBBaseTransferObject.hpp"
 #include "cpp_sqlite/src/cpp_sqlite/DBDataAccessObject.hpp"
 #include "cpp_sqlite/src/cpp_sqlite/DBDatabase.hpp"
 #include "cpp_sqlite/src/cpp_sqlite/DBRepeatedFieldTransferObject.hpp"
 #include "cpp_sqlite/test/testDatabase.hpp"
-
-struct ChildProduct : public cpp_sqlite::BaseTransferObject
-{
-  double price;
-};
-
-
-BOOST_DESCRIBE_STRUCT(ChildProduct, (cpp_sqlite::BaseTransferObject), (price));
-
-BOOST_DESCRIBE_STRUCT(cpp_sqlite::RepeatedFieldTransferObject<ChildProduct>,
-                      (),
-                      (data));
-
-// Test TransferObject class for demonstration
-struct TestProduct : public cpp_sqlite::BaseTransferObject
-{
-  std::string name;
-  float price;
-  int quantity;
-  bool in_stock;
-  cpp_sqlite::RepeatedFieldTransferObject<ChildProduct> children;
-};
-
-// Register the test class with boost::describe
-BOOST_DESCRIBE_STRUCT(TestProduct,
-                      (cpp_sqlite::BaseTransferObject),
-                      (name, price, quantity, in_stock, children));
+#include "cpp_sqlite/test/testTransferObjects.hpp"
 
 void DatabaseTest::SetUp()
 {
@@ -408,28 +394,6 @@ TEST_F(DatabaseTest, SelectWithRepeatedFields)
   CleanUp(testDbFile);
 }
 
-// Test structures for ForeignKey
-struct Vertex3D : public cpp_sqlite::BaseTransferObject
-{
-  float x;
-  float y;
-  float z;
-};
-
-BOOST_DESCRIBE_STRUCT(Vertex3D, (cpp_sqlite::BaseTransferObject), (x, y, z));
-
-struct RigidBody : public cpp_sqlite::BaseTransferObject
-{
-  std::string name;
-  float mass;
-  cpp_sqlite::ForeignKey<Vertex3D> centerOfMass;  // Lazy FK
-  Vertex3D initialPosition;                       // Eager load
-};
-
-BOOST_DESCRIBE_STRUCT(RigidBody,
-                      (cpp_sqlite::BaseTransferObject),
-                      (name, mass, centerOfMass, initialPosition));
-
 TEST_F(DatabaseTest, ForeignKeyLazyLoading)
 {
   const std::string testDbFile = "test_foreign_key.db";
@@ -668,4 +632,2150 @@ TEST_F(DatabaseTest, NamespacedTypes)
   EXPECT_FLOAT_EQ(products[0].price, 19.99f);
 
   CleanUp(testDbFile);
-}
\ No newline at end of file
+}
+
+TEST_F(DatabaseTest, BufferedInsertUsesBatchedTransactions)
+{
+  const std::string testDbFile = "test_flush_transactions.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+  vertexDAO.setMaxRowsPerTransaction(30);
+
+  for (int i = 0; i < 100; i++)
+  {
+    Vertex3D v;
+    v.x = static_cast<float>(i);
+    v.y = 0.0f;
+    v.z = 0.0f;
+    vertexDAO.addToBuffer(v);
+  }
+
+  // A manually assigned ID that collides with the counter must be reported
+  Vertex3D duplicate;
+  duplicate.id = 1;
+  vertexDAO.addToBuffer(duplicate);
+
+  auto result = vertexDAO.insert();
+
+  EXPECT_EQ(result.succeeded, 100);
+  EXPECT_EQ(result.transactions, 4);
+  ASSERT_EQ(result.failedIds.size(), 1);
+  EXPECT_EQ(result.failedIds[0], 1);
+  EXPECT_FALSE(result.ok());
+
+  EXPECT_EQ(vertexDAO.selectAll().size(), 100);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, BufferedInsertNestsInsideOpenTransaction)
+{
+  const std::string testDbFile = "test_flush_savepoint.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+
+  {
+    // The flush must use a savepoint and leave the outer transaction open
+    cpp_sqlite::Transaction outer{db};
+    ASSERT_TRUE(outer.isActive());
+    ASSERT_FALSE(outer.isSavepoint());
+
+    for (int i = 0; i < 10; i++)
+    {
+      vertexDAO.addToBuffer(Vertex3D{});
+    }
+
+    auto result = vertexDAO.insert();
+    EXPECT_EQ(result.succeeded, 10);
+    EXPECT_TRUE(result.ok());
+    EXPECT_EQ(sqlite3_get_autocommit(&db.getRawDB()), 0);
+
+    // Leaving the scope without committing rolls the rows back
+  }
+
+  EXPECT_TRUE(vertexDAO.selectAll().empty());
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, MultiRowInsertFlush)
+{
+  const std::string testDbFile = "test_multi_row_insert.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+  ASSERT_GT(vertexDAO.getMaxRowsPerInsert(), 1);
+
+  // An odd row count exercises every power-of-two chunk size
+  constexpr int rowCount = 1001;
+  for (int i = 0; i < rowCount; i++)
+  {
+    Vertex3D v;
+    v.x = static_cast<float>(i);
+    v.y = static_cast<float>(i * 2);
+    v.z = static_cast<float>(i * 3);
+    vertexDAO.addToBuffer(v);
+  }
+
+  auto result = vertexDAO.insert();
+  EXPECT_EQ(result.succeeded, rowCount);
+  EXPECT_TRUE(result.ok());
+
+  auto vertices = vertexDAO.selectAll();
+  ASSERT_EQ(vertices.size(), rowCount);
+  for (int i = 0; i < rowCount; i++)
+  {
+    EXPECT_EQ(vertices[i].id, static_cast<uint32_t>(i + 1));
+    EXPECT_FLOAT_EQ(vertices[i].x, static_cast<float>(i));
+    EXPECT_FLOAT_EQ(vertices[i].z, static_cast<float>(i * 3));
+  }
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, MultiRowInsertReportsFailedRows)
+{
+  const std::string testDbFile = "test_multi_row_insert_failure.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+
+  // A row written behind the DAO's back collides with the fifth buffered row
+  ASSERT_EQ(sqlite3_exec(&db.getRawDB(),
+                         "INSERT INTO Vertex3D (id, x, y, z) "
+                         "VALUES (5, 0, 0, 0);",
+                         nullptr,
+                         nullptr,
+                         nullptr),
+            SQLITE_OK);
+
+  for (int i = 0; i < 8; i++)
+  {
+    vertexDAO.addToBuffer(Vertex3D{});
+  }
+
+  auto result = vertexDAO.insert();
+  EXPECT_EQ(result.succeeded, 7);
+  ASSERT_EQ(result.failedIds.size(), 1);
+  EXPECT_EQ(result.failedIds[0], 5);
+
+  EXPECT_EQ(vertexDAO.selectAll().size(), 8);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, FlushRolledBackBySQLiteReportsWholeBatch)
+{
+  const std::string testDbFile = "test_flush_rolled_back.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+
+  // The fifth row of every flush ends the whole transaction, like
+  // SQLITE_FULL or SQLITE_IOERR can
+  ASSERT_EQ(sqlite3_exec(&db.getRawDB(),
+                         "CREATE TRIGGER abort_flush BEFORE INSERT ON Vertex3D "
+                         "WHEN NEW.id % 8 = 5 "
+                         "BEGIN SELECT RAISE(ROLLBACK, 'abort'); END;",
+                         nullptr,
+                         nullptr,
+                         nullptr),
+            SQLITE_OK);
+
+  // Once row by row, once with multi-row INSERT statements
+  for (std::size_t maxRowsPerInsert : {1, 4})
+  {
+    vertexDAO.setMaxRowsPerInsert(maxRowsPerInsert);
+    for (int i = 0; i < 8; i++)
+    {
+      vertexDAO.addToBuffer(Vertex3D{});
+    }
+
+    // The rows after the failed one must not be written in autocommit mode
+    auto result = vertexDAO.insert();
+    EXPECT_EQ(result.succeeded, 0);
+    EXPECT_EQ(result.failedIds.size(), 8);
+    EXPECT_TRUE(vertexDAO.selectAll().empty());
+    EXPECT_EQ(sqlite3_get_autocommit(&db.getRawDB()), 1);
+  }
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, BackgroundWriterFlushesProducerThreads)
+{
+  const std::string testDbFile = "test_background_writer.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+
+  cpp_sqlite::FlushPolicy policy;
+  policy.maxBufferedRows = 64;
+  policy.maxDelay = std::chrono::milliseconds{20};
+  db.startBackgroundWriter(policy);
+  ASSERT_TRUE(db.hasBackgroundWriter());
+
+  constexpr int producerCount = 4;
+  constexpr int rowsPerProducer = 250;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producerCount; p++)
+  {
+    producers.emplace_back(
+      [&vertexDAO]
+      {
+        for (int i = 0; i < rowsPerProducer; i++)
+        {
+          Vertex3D v;
+          v.x = static_cast<float>(i);
+          vertexDAO.addToBuffer(v);
+        }
+      });
+  }
+
+  for (auto& producer : producers)
+  {
+    producer.join();
+  }
+
+  // Everything buffered before the barrier must be committed afterwards
+  db.waitForDurable();
+  EXPECT_EQ(vertexDAO.bufferedCount(), 0);
+  EXPECT_EQ(vertexDAO.selectAll().size(), producerCount * rowsPerProducer);
+
+  db.stopBackgroundWriter();
+  EXPECT_FALSE(db.hasBackgroundWriter());
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, BackgroundWriterFlushesOnShutdown)
+{
+  const std::string testDbFile = "test_background_writer_shutdown.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+    auto& vertexDAO = db.getDAO<Vertex3D>();
+
+    // A policy that never triggers on its own
+    cpp_sqlite::FlushPolicy policy;
+    policy.maxBufferedRows = 1000000;
+    policy.maxDelay = std::chrono::hours{1};
+    db.startBackgroundWriter(policy);
+
+    for (int i = 0; i < 10; i++)
+    {
+      vertexDAO.addToBuffer(Vertex3D{});
+    }
+
+    // Destroying the database stops the writer after a final flush
+  }
+
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+  EXPECT_EQ(db.getDAO<Vertex3D>().selectAll().size(), 10);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, LockFreeBufferWithConcurrentProducers)
+{
+  const std::string testDbFile = "test_lock_free_buffer.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+  vertexDAO.setBufferBackend(cpp_sqlite::BufferBackend::LockFree,
+                             256,
+                             cpp_sqlite::BufferFullPolicy::Block);
+  ASSERT_EQ(vertexDAO.getBufferBackend(), cpp_sqlite::BufferBackend::LockFree);
+
+  // A small ring forces producers to wait for the background writer
+  cpp_sqlite::FlushPolicy policy;
+  policy.maxBufferedRows = 128;
+  policy.pollInterval = std::chrono::milliseconds{1};
+  db.startBackgroundWriter(policy);
+
+  constexpr int producerCount = 8;
+  constexpr int rowsPerProducer = 1000;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p < producerCount; p++)
+  {
+    producers.emplace_back(
+      [&vertexDAO, p]
+      {
+        for (int i = 0; i < rowsPerProducer; i++)
+        {
+          Vertex3D v;
+          v.x = static_cast<float>(p);
+          v.y = static_cast<float>(i);
+          EXPECT_TRUE(vertexDAO.addToBuffer(v));
+        }
+      });
+  }
+
+  for (auto& producer : producers)
+  {
+    producer.join();
+  }
+
+  db.waitForDurable();
+  db.stopBackgroundWriter();
+
+  EXPECT_EQ(vertexDAO.selectAll().size(), producerCount * rowsPerProducer);
+
+  auto stats = vertexDAO.bufferStats();
+  EXPECT_EQ(stats.dropped, 0);
+  EXPECT_LE(stats.highWaterMark, 256);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, LockFreeBufferFullPolicies)
+{
+  const std::string testDbFile = "test_lock_free_buffer_full.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+    auto& vertexDAO = db.getDAO<Vertex3D>();
+
+    // Drop: rows beyond the capacity are counted and discarded
+    ASSERT_TRUE(
+      vertexDAO.setBufferBackend(cpp_sqlite::BufferBackend::LockFree,
+                                 16,
+                                 cpp_sqlite::BufferFullPolicy::Drop));
+
+    int accepted = 0;
+    for (int i = 0; i < 100; i++)
+    {
+      accepted += vertexDAO.addToBuffer(Vertex3D{}) ? 1 : 0;
+    }
+
+    EXPECT_EQ(accepted, 16);
+    EXPECT_EQ(vertexDAO.bufferedCount(), 16);
+    EXPECT_EQ(vertexDAO.bufferStats().dropped, 84);
+    EXPECT_EQ(vertexDAO.bufferStats().highWaterMark, 16);
+    EXPECT_EQ(vertexDAO.insert().succeeded, 16);
+
+    // Producers may still hold the ring buffer, so the backend is fixed
+    EXPECT_FALSE(
+      vertexDAO.setBufferBackend(cpp_sqlite::BufferBackend::LockFree,
+                                 16,
+                                 cpp_sqlite::BufferFullPolicy::Grow));
+    EXPECT_EQ(vertexDAO.getBufferBackend(),
+              cpp_sqlite::BufferBackend::LockFree);
+  }
+
+  // A fresh database, since ids are not resumed from existing rows
+  CleanUp(testDbFile);
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+
+  // The background writer polls the buffer without taking its lock
+  db.startBackgroundWriter();
+  EXPECT_FALSE(vertexDAO.setBufferBackend(cpp_sqlite::BufferBackend::LockFree));
+  db.stopBackgroundWriter();
+
+  // Grow: rows beyond the capacity spill into the overflow list
+  ASSERT_TRUE(vertexDAO.setBufferBackend(cpp_sqlite::BufferBackend::LockFree,
+                                         16,
+                                         cpp_sqlite::BufferFullPolicy::Grow));
+
+  for (int i = 0; i < 100; i++)
+  {
+    EXPECT_TRUE(vertexDAO.addToBuffer(
+      Vertex3D{{}, static_cast<float>(i), 0.0f, 0.0f}));
+  }
+
+  // Spilled rows still count as buffered
+  EXPECT_EQ(vertexDAO.bufferedCount(), 100);
+  EXPECT_EQ(vertexDAO.bufferStats().overflowed, 84);
+  EXPECT_EQ(vertexDAO.insert().succeeded, 100);
+  EXPECT_EQ(vertexDAO.bufferedCount(), 0);
+
+  // Ring and overflow rows are written in the order they were buffered
+  auto vertices = vertexDAO.selectAll();
+  ASSERT_EQ(vertices.size(), 100);
+  std::ranges::sort(vertices, {}, &Vertex3D::id);
+  for (std::size_t i = 0; i < vertices.size(); i++)
+  {
+    EXPECT_EQ(vertices[i].x, static_cast<float>(i));
+  }
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, MoveAndEmplaceIntoBuffer)
+{
+  const std::string testDbFile = "test_move_emplace_buffer.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& productDAO = db.getDAO<TestProduct>();
+
+  TestProduct product;
+  product.name = "Moved Widget";
+  product.price = 5.0f;
+  product.quantity = 3;
+  product.in_stock = true;
+  product.children.data = {ChildProduct{{}, 1.5}, ChildProduct{{}, 2.5}};
+
+  // Moving hands the children vector over instead of copying it
+  productDAO.addToBuffer(std::move(product));
+  EXPECT_TRUE(product.children.data.empty());
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+  vertexDAO.emplaceToBuffer(cpp_sqlite::BaseTransferObject{}, 1.0f, 2.0f, 3.0f);
+
+  EXPECT_TRUE(productDAO.insert().ok());
+  EXPECT_TRUE(vertexDAO.insert().ok());
+
+  auto products = productDAO.selectAll();
+  ASSERT_EQ(products.size(), 1);
+  EXPECT_EQ(products[0].name, "Moved Widget");
+  EXPECT_EQ(products[0].children.data.size(), 2);
+
+  auto vertices = vertexDAO.selectAll();
+  ASSERT_EQ(vertices.size(), 1);
+  EXPECT_FLOAT_EQ(vertices[0].y, 2.0f);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, ReservedBufferDoesNotAllocate)
+{
+  const std::string testDbFile = "test_reserved_buffer.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+  vertexDAO.reserveBuffer(128);
+
+  // Several flushes so that both halves of the double buffer are used
+  for (int round = 0; round < 3; round++)
+  {
+    const std::size_t capacity = vertexDAO.bufferCapacity();
+    ASSERT_GE(capacity, 128) << "Buffer not reserved in round " << round;
+
+    for (int i = 0; i < 128; i++)
+    {
+      Vertex3D v;
+      v.x = static_cast<float>(i);
+      vertexDAO.addToBuffer(v);
+    }
+
+    // The buffer never grew, so it was never reallocated
+    EXPECT_EQ(vertexDAO.bufferCapacity(), capacity)
+      << "Buffering allocated in round " << round;
+
+    EXPECT_TRUE(vertexDAO.insert().ok());
+  }
+
+  EXPECT_EQ(vertexDAO.selectAll().size(), 3 * 128);
+
+  CleanUp(testDbFile);
+}
+
+namespace
+{
+// Count the statements currently prepared on a connection
+int countPreparedStatements(sqlite3& db)
+{
+  int count = 0;
+  for (sqlite3_stmt* stmt = sqlite3_next_stmt(&db, nullptr); stmt != nullptr;
+       stmt = sqlite3_next_stmt(&db, stmt))
+  {
+    count++;
+  }
+  return count;
+}
+}  // namespace
+
+TEST_F(DatabaseTest, JunctionStatementsArePreparedOnce)
+{
+  const std::string testDbFile = "test_junction_statements.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& productDAO = db.getDAO<TestProduct>();
+  auto& childDAO = db.getDAO<ChildProduct>();
+
+  ASSERT_NE(productDAO.getJunctionInsertStatement<ChildProduct>(), nullptr);
+  ASSERT_NE(productDAO.getJunctionSelectStatement<ChildProduct>(1), nullptr);
+  EXPECT_EQ(productDAO.getJunctionInsertStatement<Vertex3D>(), nullptr);
+
+  // Disable multi-row statements so the statement count stays fixed
+  childDAO.setMaxRowsPerInsert(1);
+  const int statementsBefore = countPreparedStatements(db.getRawDB());
+
+  for (int i = 0; i < 20; i++)
+  {
+    TestProduct product;
+    product.name = "Product " + std::to_string(i);
+    product.children.data = {ChildProduct{{}, 1.0 * i}, ChildProduct{{}, 2.0}};
+    productDAO.addToBuffer(std::move(product));
+  }
+  ASSERT_TRUE(productDAO.insert().ok());
+
+  // The inserts prepared no new statement
+  EXPECT_EQ(countPreparedStatements(db.getRawDB()), statementsBefore);
+
+  // The first load prepares the batched child lookups it needs; loading
+  // again reuses them
+  productDAO.selectAll();
+  const int statementsAfterLoad = countPreparedStatements(db.getRawDB());
+
+  auto products = productDAO.selectAll();
+  ASSERT_EQ(products.size(), 20);
+  for (const auto& product : products)
+  {
+    EXPECT_EQ(product.children.data.size(), 2);
+  }
+
+  EXPECT_EQ(countPreparedStatements(db.getRawDB()), statementsAfterLoad);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, RepeatedFieldsLoadedForWholeResultSet)
+{
+  const std::string testDbFile = "test_repeated_batch_load.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& productDAO = db.getDAO<TestProduct>();
+
+  // Enough parents to need several batched lookups, with a varying number
+  // of children (including none)
+  const int productCount = 600;
+  for (int i = 0; i < productCount; i++)
+  {
+    TestProduct product;
+    product.name = "Product " + std::to_string(i);
+    for (int c = 0; c < i % 4; c++)
+    {
+      product.children.data.push_back(ChildProduct{{}, i + 0.25 * c});
+    }
+    productDAO.addToBuffer(std::move(product));
+  }
+  ASSERT_TRUE(productDAO.insert().ok());
+
+  auto products = productDAO.selectAll();
+  ASSERT_EQ(products.size(), productCount);
+
+  for (const auto& product : products)
+  {
+    const int i = std::stoi(product.name.substr(8));
+    ASSERT_EQ(product.children.data.size(), i % 4) << product.name;
+
+    for (int c = 0; c < i % 4; c++)
+    {
+      EXPECT_DOUBLE_EQ(product.children.data[c].price, i + 0.25 * c);
+    }
+  }
+
+  // A single parent is loaded through the same path
+  auto single = productDAO.selectById(products[3].id);
+  ASSERT_TRUE(single.has_value());
+  EXPECT_EQ(single->children.data.size(), products[3].children.data.size());
+
+  CleanUp(testDbFile);
+}
+
+// Nests a transfer object that itself nests one, and one with repeated
+// fields
+struct Assembly : public cpp_sqlite::BaseTransferObject
+{
+  std::string label;
+  RigidBody body;
+  TestProduct product;
+};
+
+BOOST_DESCRIBE_STRUCT(Assembly,
+                      (cpp_sqlite::BaseTransferObject),
+                      (label, body, product));
+
+namespace
+{
+// Snapshot how many times each statement on a connection has been run
+std::unordered_map<sqlite3_stmt*, int> statementRuns(sqlite3& db)
+{
+  std::unordered_map<sqlite3_stmt*, int> runs;
+  for (sqlite3_stmt* stmt = sqlite3_next_stmt(&db, nullptr); stmt != nullptr;
+       stmt = sqlite3_next_stmt(&db, stmt))
+  {
+    runs[stmt] = sqlite3_stmt_status(stmt, SQLITE_STMTSTATUS_RUN, 0);
+  }
+  return runs;
+}
+
+// Count the statements that were run since a snapshot was taken
+int countStatementsRunSince(sqlite3& db,
+                            const std::unordered_map<sqlite3_stmt*, int>& before)
+{
+  int count = 0;
+  for (const auto& [stmt, runs] : statementRuns(db))
+  {
+    auto it = before.find(stmt);
+    if (it == before.end() || it->second != runs)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+}  // namespace
+
+TEST_F(DatabaseTest, NestedObjectsLoadedWithJoin)
+{
+  const std::string testDbFile = "test_nested_join.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& assemblyDAO = db.getDAO<Assembly>();
+  ASSERT_TRUE(assemblyDAO.isInitialized());
+
+  const int assemblyCount = 8;
+  for (int i = 0; i < assemblyCount; i++)
+  {
+    Assembly assembly;
+    assembly.label = "Assembly " + std::to_string(i);
+    assembly.body.name = "Body " + std::to_string(i);
+    assembly.body.mass = 1.5f * i;
+    assembly.body.initialPosition.x = 1.0f * i;
+    assembly.body.initialPosition.y = 2.0f * i;
+    assembly.body.initialPosition.z = 3.0f * i;
+    assembly.product.name = "Product " + std::to_string(i);
+    assembly.product.children.data = {ChildProduct{{}, 10.0 + i}};
+    assemblyDAO.addToBuffer(std::move(assembly));
+  }
+  ASSERT_TRUE(assemblyDAO.insert().ok());
+
+  // Every nested object comes from the same row as its parent, so the only
+  // other statement run is the batched lookup of the repeated children
+  const auto runsBefore = statementRuns(db.getRawDB());
+  auto assemblies = assemblyDAO.selectAll();
+  EXPECT_EQ(countStatementsRunSince(db.getRawDB(), runsBefore), 2);
+
+  ASSERT_EQ(assemblies.size(), assemblyCount);
+  for (int i = 0; i < assemblyCount; i++)
+  {
+    const auto& assembly = assemblies[i];
+    EXPECT_EQ(assembly.label, "Assembly " + std::to_string(i));
+    EXPECT_EQ(assembly.body.name, "Body " + std::to_string(i));
+    EXPECT_FLOAT_EQ(assembly.body.mass, 1.5f * i);
+    EXPECT_FLOAT_EQ(assembly.body.initialPosition.x, 1.0f * i);
+    EXPECT_FLOAT_EQ(assembly.body.initialPosition.y, 2.0f * i);
+    EXPECT_FLOAT_EQ(assembly.body.initialPosition.z, 3.0f * i);
+    EXPECT_EQ(assembly.product.name, "Product " + std::to_string(i));
+    ASSERT_EQ(assembly.product.children.data.size(), 1);
+    EXPECT_DOUBLE_EQ(assembly.product.children.data[0].price, 10.0 + i);
+  }
+
+  // A missing nested row leaves the nested object default-constructed with
+  // its ID set
+  const uint32_t missingId = assemblies[0].body.initialPosition.id;
+  ASSERT_EQ(sqlite3_exec(&db.getRawDB(),
+                         ("DELETE FROM Vertex3D WHERE id = " +
+                          std::to_string(missingId) + ";")
+                           .c_str(),
+                         nullptr,
+                         nullptr,
+                         nullptr),
+            SQLITE_OK);
+
+  auto reloaded = assemblyDAO.selectById(assemblies[0].id);
+  ASSERT_TRUE(reloaded.has_value());
+  EXPECT_EQ(reloaded->body.name, "Body 0");
+  EXPECT_EQ(reloaded->body.initialPosition.id, missingId);
+  EXPECT_EQ(reloaded->product.name, "Product 0");
+  EXPECT_EQ(reloaded->product.children.data.size(), 1);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, JunctionTableIsKeyedAndMigrated)
+{
+  const std::string testDbFile = "test_junction_migration.db";
+
+  CleanUp(testDbFile);
+
+  // Create the tables with the unkeyed junction layout of earlier versions,
+  // including a duplicated link
+  {
+    cpp_sqlite::Database db{testDbFile, true};
+    const char* legacySchema =
+      "CREATE TABLE TestProduct (id INTEGER PRIMARY KEY, name TEXT, price "
+      "FLOAT, quantity INTEGER, in_stock INTEGER);"
+      "CREATE TABLE ChildProduct (id INTEGER PRIMARY KEY, price FLOAT);"
+      "CREATE TABLE TestProduct_ChildProduct(TestProduct_id INTEGER, "
+      "ChildProduct_id INTEGER);"
+      "INSERT INTO TestProduct VALUES (1, 'Legacy', 1.0, 1, 1);"
+      "INSERT INTO ChildProduct VALUES (1, 5.0), (2, 6.0);"
+      "INSERT INTO TestProduct_ChildProduct VALUES (1, 1), (1, 2), (1, 2);";
+    ASSERT_EQ(
+      sqlite3_exec(&db.getRawDB(), legacySchema, nullptr, nullptr, nullptr),
+      SQLITE_OK);
+  }
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& productDAO = db.getDAO<TestProduct>();
+  ASSERT_TRUE(productDAO.isInitialized());
+
+  // The junction table was rebuilt with a composite primary key
+  sqlite3_stmt* rawPtr = nullptr;
+  ASSERT_EQ(sqlite3_prepare_v2(&db.getRawDB(),
+                               "SELECT sql FROM sqlite_master WHERE name = "
+                               "'TestProduct_ChildProduct';",
+                               -1,
+                               &rawPtr,
+                               nullptr),
+            SQLITE_OK);
+  ASSERT_EQ(sqlite3_step(rawPtr), SQLITE_ROW);
+  std::string schema{
+    reinterpret_cast<const char*>(sqlite3_column_text(rawPtr, 0))};
+  sqlite3_finalize(rawPtr);
+  EXPECT_NE(schema.find("WITHOUT ROWID"), std::string::npos) << schema;
+  EXPECT_NE(schema.find("PRIMARY KEY"), std::string::npos) << schema;
+
+  // Lookups by parent use the key instead of scanning the table
+  ASSERT_EQ(sqlite3_prepare_v2(&db.getRawDB(),
+                               "EXPLAIN QUERY PLAN SELECT ChildProduct_id "
+                               "FROM TestProduct_ChildProduct WHERE "
+                               "TestProduct_id = 1;",
+                               -1,
+                               &rawPtr,
+                               nullptr),
+            SQLITE_OK);
+  ASSERT_EQ(sqlite3_step(rawPtr), SQLITE_ROW);
+  std::string plan{
+    reinterpret_cast<const char*>(sqlite3_column_text(rawPtr, 3))};
+  sqlite3_finalize(rawPtr);
+  EXPECT_NE(plan.find("SEARCH"), std::string::npos) << plan;
+
+  // The existing links survived the migration, without the duplicate
+  auto product = productDAO.selectById(1);
+  ASSERT_TRUE(product.has_value());
+  ASSERT_EQ(product->children.data.size(), 2);
+  EXPECT_DOUBLE_EQ(product->children.data[0].price, 5.0);
+  EXPECT_DOUBLE_EQ(product->children.data[1].price, 6.0);
+
+  EXPECT_TRUE(productDAO.createJunctionReverseIndexes());
+  bool indexFound = false;
+  EXPECT_EQ(sqlite3_exec(&db.getRawDB(),
+                         "SELECT 1 FROM sqlite_master WHERE type = 'index' "
+                         "AND name = 'TestProduct_ChildProduct_reverse';",
+                         [](void* found, int, char**, char**)
+                         {
+                           *static_cast<bool*>(found) = true;
+                           return 0;
+                         },
+                         &indexFound,
+                         nullptr),
+            SQLITE_OK);
+  EXPECT_TRUE(indexFound);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, CursorStreamsAllRows)
+{
+  const std::string testDbFile = "test_cursor.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  static_assert(std::ranges::input_range<cpp_sqlite::Cursor<TestProduct>>);
+
+  auto& productDAO = db.getDAO<TestProduct>();
+
+  // More rows than fit in one page of a type with repeated fields
+  const int productCount = 600;
+  for (int i = 0; i < productCount; i++)
+  {
+    TestProduct product;
+    product.name = "Product " + std::to_string(i);
+    product.quantity = i;
+    product.children.data = {ChildProduct{{}, 1.0 * i}};
+    productDAO.addToBuffer(std::move(product));
+  }
+  ASSERT_TRUE(productDAO.insert().ok());
+
+  int rowCount = 0;
+  for (const auto& product : productDAO.selectAllCursor())
+  {
+    EXPECT_EQ(product.quantity, rowCount);
+    ASSERT_EQ(product.children.data.size(), 1);
+    EXPECT_DOUBLE_EQ(product.children.data[0].price, 1.0 * rowCount);
+    rowCount++;
+  }
+  EXPECT_EQ(rowCount, productCount);
+
+  // Works with range algorithms; a flat type is decoded row by row
+  auto& childDAO = db.getDAO<ChildProduct>();
+  auto childCursor = childDAO.selectAllCursor();
+  EXPECT_EQ(std::ranges::count_if(childCursor,
+                                  [](const ChildProduct& child)
+                                  { return child.price >= 500.0; }),
+            100);
+
+  // Stopping early leaves the database usable
+  {
+    auto cursor = productDAO.selectAllCursor();
+    auto it = std::ranges::find_if(cursor,
+                                   [](const TestProduct& product)
+                                   { return product.quantity == 10; });
+    ASSERT_NE(it, cursor.end());
+    EXPECT_EQ(it->name, "Product 10");
+  }
+
+  TestProduct extra;
+  extra.name = "Extra";
+  ASSERT_TRUE(productDAO.insert(extra));
+  EXPECT_EQ(productDAO.selectAll().size(), productCount + 1);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, RowViewsReadColumnsInPlace)
+{
+  const std::string testDbFile = "test_row_views.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  static_assert(
+    std::ranges::input_range<cpp_sqlite::RowViewCursor<DocumentRecord>>);
+
+  auto& docDAO = db.getDAO<DocumentRecord>();
+
+  const int docCount = 20;
+  for (int i = 0; i < docCount; i++)
+  {
+    DocumentRecord doc;
+    doc.title = "Title " + std::to_string(i);
+    doc.author = "Author";
+    doc.file_data.assign(static_cast<std::size_t>(i), static_cast<uint8_t>(i));
+    docDAO.addToBuffer(std::move(doc));
+  }
+  ASSERT_TRUE(docDAO.insert().ok());
+
+  int rowCount = 0;
+  for (auto row : docDAO.selectAllViews())
+  {
+    std::string_view title = row.get<&DocumentRecord::title>();
+    std::span<const uint8_t> data = row.get<&DocumentRecord::file_data>();
+
+    EXPECT_EQ(row.get<&DocumentRecord::id>(),
+              static_cast<uint32_t>(rowCount + 1));
+    EXPECT_EQ(title, "Title " + std::to_string(rowCount));
+    ASSERT_EQ(data.size(), static_cast<std::size_t>(rowCount));
+    EXPECT_TRUE(std::ranges::all_of(
+      data, [&](uint8_t byte) { return byte == rowCount; }));
+    rowCount++;
+  }
+  EXPECT_EQ(rowCount, docCount);
+
+  // Nested objects are viewed through their joined columns
+  auto& bodyDAO = db.getDAO<RigidBody>();
+
+  RigidBody body;
+  body.name = "Cube";
+  body.mass = 2.0f;
+  body.centerOfMass.id = uint32_t{7};
+  body.initialPosition.x = 1.0f;
+  body.initialPosition.y = 2.0f;
+  body.initialPosition.z = 3.0f;
+  ASSERT_TRUE(bodyDAO.insert(body));
+
+  auto bodyViews = bodyDAO.selectAllViews();
+  auto it = bodyViews.begin();
+  ASSERT_NE(it, bodyViews.end());
+
+  auto bodyView = *it;
+  EXPECT_EQ(bodyView.get<&RigidBody::name>(), "Cube");
+  EXPECT_FLOAT_EQ(bodyView.get<&RigidBody::mass>(), 2.0f);
+  EXPECT_EQ(bodyView.get<&RigidBody::centerOfMass>(), 7u);
+
+  auto position = bodyView.get<&RigidBody::initialPosition>();
+  ASSERT_FALSE(position.isNull());
+  EXPECT_FLOAT_EQ(position.get<&Vertex3D::x>(), 1.0f);
+  EXPECT_FLOAT_EQ(position.get<&Vertex3D::z>(), 3.0f);
+
+  ++it;
+  EXPECT_EQ(it, bodyViews.end());
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, SelectCacheIsBounded)
+{
+  const std::string testDbFile = "test_select_cache.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  // Only rows that are read are cached
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+  vertexDAO.setCacheWriteThrough(false);
+  for (int i = 1; i <= 10; i++)
+  {
+    Vertex3D vertex;
+    vertex.x = static_cast<float>(i);
+    vertexDAO.addToBuffer(std::move(vertex));
+  }
+  ASSERT_TRUE(vertexDAO.insert().ok());
+
+  // A resolved foreign key pins its row through later evictions
+  vertexDAO.setCachePolicy(cpp_sqlite::CachePolicy::LRU, 2);
+  cpp_sqlite::ForeignKey<Vertex3D> first{1};
+  const auto resolved = first.resolve(db);
+  ASSERT_TRUE(resolved.has_value());
+
+  for (uint32_t id = 2; id <= 10; id++)
+  {
+    ASSERT_NE(vertexDAO.selectCacheById(id), nullptr);
+  }
+  EXPECT_FLOAT_EQ(resolved->get().x, 1.0f);
+
+  auto stats = vertexDAO.cacheStats();
+  EXPECT_EQ(stats.entries, 2);
+  EXPECT_EQ(stats.misses, 10);
+  EXPECT_EQ(stats.evictions, 8);
+
+  // LRU keeps the most recently used entry
+  vertexDAO.selectCacheById(9);
+  vertexDAO.selectCacheById(1);
+  EXPECT_EQ(vertexDAO.cacheStats().hits, 1);
+  vertexDAO.selectCacheById(9);
+  EXPECT_EQ(vertexDAO.cacheStats().hits, 2);
+
+  // CLOCK gives a referenced entry a second chance
+  vertexDAO.setCachePolicy(cpp_sqlite::CachePolicy::Clock, 3);
+  vertexDAO.selectCacheById(2);
+  vertexDAO.selectCacheById(1);
+  vertexDAO.selectCacheById(3);
+  const auto before = vertexDAO.cacheStats();
+  vertexDAO.selectCacheById(1);
+  EXPECT_EQ(vertexDAO.cacheStats().hits, before.hits + 1);
+  vertexDAO.selectCacheById(9);
+  EXPECT_EQ(vertexDAO.cacheStats().misses, before.misses + 1);
+
+  // A byte budget limits the cache by estimated size
+  vertexDAO.setCachePolicy(
+    cpp_sqlite::CachePolicy::LRU, 0, 4 * sizeof(Vertex3D));
+  for (uint32_t id = 1; id <= 10; id++)
+  {
+    vertexDAO.selectCacheById(id);
+  }
+  stats = vertexDAO.cacheStats();
+  EXPECT_EQ(stats.entries, 4);
+  EXPECT_LE(stats.bytes, 4 * sizeof(Vertex3D));
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, SelectCacheFollowsWrites)
+{
+  const std::string testDbFile = "test_cache_coherence.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& bodyDAO = db.getDAO<RigidBody>();
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+
+  RigidBody body;
+  body.name = "Cube";
+  body.initialPosition.x = 1.0f;
+  ASSERT_TRUE(bodyDAO.insert(body));
+
+  auto cachedBody = bodyDAO.selectCacheById(body.id);
+  auto cachedVertex = vertexDAO.selectCacheById(body.initialPosition.id);
+  ASSERT_NE(cachedBody, nullptr);
+  ASSERT_NE(cachedVertex, nullptr);
+
+  // Writes that bypass the DAO are caught by the update hook. The nested
+  // row's parent is invalidated as well.
+  const std::string update = "UPDATE Vertex3D SET x = 2.0 WHERE id = " +
+                             std::to_string(body.initialPosition.id) + ";";
+  ASSERT_EQ(
+    sqlite3_exec(&db.getRawDB(), update.c_str(), nullptr, nullptr, nullptr),
+    SQLITE_OK);
+
+  EXPECT_FLOAT_EQ(vertexDAO.selectCacheById(body.initialPosition.id)->x, 2.0f);
+  EXPECT_FLOAT_EQ(bodyDAO.selectCacheById(body.id)->initialPosition.x, 2.0f);
+
+  // Rows handed out before the write are unaffected
+  EXPECT_FLOAT_EQ(cachedVertex->x, 1.0f);
+
+  const std::string remove =
+    "DELETE FROM RigidBody WHERE id = " + std::to_string(body.id) + ";";
+  ASSERT_EQ(
+    sqlite3_exec(&db.getRawDB(), remove.c_str(), nullptr, nullptr, nullptr),
+    SQLITE_OK);
+  EXPECT_EQ(bodyDAO.selectCacheById(body.id), nullptr);
+
+  // Inserted rows are written through to the cache by default
+  Vertex3D vertex;
+  vertex.x = 3.0f;
+  ASSERT_TRUE(vertexDAO.insert(vertex));
+
+  const auto hitsBefore = vertexDAO.cacheStats().hits;
+  auto written = vertexDAO.selectCacheById(vertex.id);
+  ASSERT_NE(written, nullptr);
+  EXPECT_FLOAT_EQ(written->x, 3.0f);
+  EXPECT_EQ(vertexDAO.cacheStats().hits, hitsBefore + 1);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, RolledBackWritesLeaveNoCachedRows)
+{
+  const std::string testDbFile = "test_cache_rollback.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+
+  Vertex3D committed;
+  committed.x = 1.0f;
+  ASSERT_TRUE(vertexDAO.insert(committed));
+
+  // A row written through inside a transaction is dropped on rollback
+  Vertex3D phantom;
+  phantom.x = 2.0f;
+  {
+    cpp_sqlite::Transaction transaction{db, logger.getLogger()};
+    ASSERT_TRUE(vertexDAO.insert(phantom));
+    ASSERT_NE(vertexDAO.selectCacheById(phantom.id), nullptr);
+  }
+  EXPECT_EQ(vertexDAO.selectCacheById(phantom.id), nullptr);
+
+  // So is a row that was read back after an update that is rolled back
+  const std::string update = "UPDATE Vertex3D SET x = 9.0 WHERE id = " +
+                             std::to_string(committed.id) + ";";
+  {
+    cpp_sqlite::Transaction transaction{db, logger.getLogger()};
+    ASSERT_EQ(
+      sqlite3_exec(&db.getRawDB(), update.c_str(), nullptr, nullptr, nullptr),
+      SQLITE_OK);
+    EXPECT_FLOAT_EQ(vertexDAO.selectCacheById(committed.id)->x, 9.0f);
+    transaction.rollback();
+  }
+  EXPECT_FLOAT_EQ(vertexDAO.selectCacheById(committed.id)->x, 1.0f);
+
+  // Rolling back to a savepoint does not invoke the rollback hook
+  Vertex3D nested;
+  nested.x = 3.0f;
+  {
+    cpp_sqlite::Transaction transaction{db, logger.getLogger()};
+    {
+      cpp_sqlite::Transaction savepoint{db, logger.getLogger()};
+      ASSERT_TRUE(savepoint.isSavepoint());
+      ASSERT_TRUE(vertexDAO.insert(nested));
+      ASSERT_NE(vertexDAO.selectCacheById(nested.id), nullptr);
+    }
+    EXPECT_EQ(vertexDAO.selectCacheById(nested.id), nullptr);
+    EXPECT_TRUE(transaction.commit());
+  }
+  EXPECT_EQ(vertexDAO.selectCacheById(nested.id), nullptr);
+
+  // Committed rows stay cached
+  Vertex3D kept;
+  kept.x = 4.0f;
+  {
+    cpp_sqlite::Transaction transaction{db, logger.getLogger()};
+    ASSERT_TRUE(vertexDAO.insert(kept));
+    EXPECT_TRUE(transaction.commit());
+  }
+  const auto hitsBefore = vertexDAO.cacheStats().hits;
+  ASSERT_NE(vertexDAO.selectCacheById(kept.id), nullptr);
+  EXPECT_EQ(vertexDAO.cacheStats().hits, hitsBefore + 1);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, ForeignKeysResolvedForWholeResultSet)
+{
+  const std::string testDbFile = "test_resolve_all.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  // Only rows that are read are cached, so every key starts cold
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+  auto& bodyDAO = db.getDAO<RigidBody>();
+  vertexDAO.setCacheWriteThrough(false);
+
+  // Enough distinct keys to need more than one lookup
+  const uint32_t vertexCount = 300;
+  for (uint32_t i = 1; i <= vertexCount; i++)
+  {
+    Vertex3D vertex;
+    vertex.x = static_cast<float>(i);
+    vertexDAO.addToBuffer(std::move(vertex));
+  }
+  ASSERT_TRUE(vertexDAO.insert().ok());
+
+  // Every vertex is referenced twice, and one body refers to no vertex
+  for (uint32_t i = 0; i < 2 * vertexCount; i++)
+  {
+    RigidBody body;
+    body.name = "Body " + std::to_string(i);
+    body.centerOfMass.id = i % vertexCount + 1;
+    bodyDAO.addToBuffer(std::move(body));
+  }
+  RigidBody missing;
+  missing.name = "Missing";
+  missing.centerOfMass.id = 100 * vertexCount;
+  bodyDAO.addToBuffer(std::move(missing));
+  ASSERT_TRUE(bodyDAO.insert().ok());
+
+  auto bodies = bodyDAO.selectAll();
+  ASSERT_EQ(bodies.size(), 2 * vertexCount + 1);
+
+  const int statementsBefore = countPreparedStatements(db.getRawDB());
+  const std::size_t resolved = cpp_sqlite::resolveAll(
+    bodies | std::views::transform(&RigidBody::centerOfMass), db);
+  EXPECT_EQ(resolved, 2 * vertexCount);
+
+  // Misses are fetched with one set-based statement per power-of-two chunk
+  EXPECT_EQ(countPreparedStatements(db.getRawDB()) - statementsBefore,
+            std::popcount(vertexCount + 1));
+
+  auto stats = vertexDAO.cacheStats();
+  EXPECT_EQ(stats.misses, vertexCount + 1);
+  EXPECT_EQ(stats.entries, vertexCount);
+
+  for (auto& body : bodies)
+  {
+    if (body.name == "Missing")
+    {
+      EXPECT_FALSE(body.centerOfMass.resolve(db).has_value());
+      continue;
+    }
+    ASSERT_NE(body.centerOfMass.data_, nullptr);
+    EXPECT_FLOAT_EQ(body.centerOfMass.data_->x,
+                    static_cast<float>(body.centerOfMass.id));
+  }
+
+  // A second pass is served from the cache
+  std::vector<cpp_sqlite::ForeignKey<Vertex3D>> keys;
+  for (uint32_t i = 1; i <= vertexCount; i++)
+  {
+    keys.emplace_back(i);
+  }
+  EXPECT_EQ(cpp_sqlite::resolveAll(keys, db), vertexCount);
+  EXPECT_EQ(vertexDAO.cacheStats().hits, stats.hits + vertexCount);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, ReadPoolServesReadsOnSeparateConnections)
+{
+  const std::string testDbFile = "test_read_pool.db";
+
+  CleanUp(testDbFile);
+  CleanUp(testDbFile + "-wal");
+  CleanUp(testDbFile + "-shm");
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+    auto& productDAO = db.getDAO<TestProduct>();
+    for (int i = 0; i < 10; i++)
+    {
+      TestProduct product;
+      product.name = "Product " + std::to_string(i);
+      product.children.data = {ChildProduct{{}, 1.0 * i}};
+      productDAO.addToBuffer(std::move(product));
+    }
+    ASSERT_TRUE(productDAO.insert().ok());
+
+    cpp_sqlite::Database memoryDb{":memory:", true, logger.getLogger()};
+    EXPECT_FALSE(memoryDb.openReadPool(2));
+
+    ASSERT_TRUE(db.openReadPool(2));
+    EXPECT_EQ(db.readerCount(), 2);
+
+    // Uncommitted rows are only visible to the thread that wrote them
+    {
+      cpp_sqlite::Transaction transaction{db};
+      TestProduct extra;
+      extra.name = "Extra";
+      ASSERT_TRUE(productDAO.insert(extra));
+
+      EXPECT_EQ(productDAO.selectAll().size(), 11);
+
+      std::size_t seenByReader = 0;
+      std::thread reader{[&] { seenByReader = productDAO.selectAll().size(); }};
+      reader.join();
+      EXPECT_EQ(seenByReader, 10);
+
+      ASSERT_TRUE(transaction.commit());
+    }
+
+    // Concurrent readers each use their own connection
+    std::vector<std::thread> readers;
+    std::atomic<int> mismatches{0};
+    for (int t = 0; t < 4; t++)
+    {
+      readers.emplace_back(
+        [&]
+        {
+          for (int i = 0; i < 20; i++)
+          {
+            auto products = productDAO.selectAll();
+            auto product = productDAO.selectById(1);
+            if (products.size() != 11 || !product.has_value() ||
+                product->children.data.size() != 1)
+            {
+              mismatches++;
+            }
+          }
+        });
+    }
+    for (auto& reader : readers)
+    {
+      reader.join();
+    }
+    EXPECT_EQ(mismatches.load(), 0);
+
+    auto lease = db.leaseReader();
+    ASSERT_TRUE(lease);
+    EXPECT_TRUE(lease->getDAO<TestProduct>().isInitialized());
+  }
+
+  CleanUp(testDbFile);
+  CleanUp(testDbFile + "-wal");
+  CleanUp(testDbFile + "-shm");
+}
+
+TEST_F(DatabaseTest, GetDAOIsSafeFromManyThreads)
+{
+  const std::string testDbFile = "test_dao_registry.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  // Every thread races to create the same DAOs on first use
+  const int threadCount = 8;
+  std::atomic<int> waiting{threadCount};
+  std::vector<const void*> productDAOs(threadCount);
+  std::vector<const void*> documentDAOs(threadCount);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < threadCount; t++)
+  {
+    threads.emplace_back(
+      [&, t]
+      {
+        waiting--;
+        while (waiting.load() > 0)
+        {
+          std::this_thread::yield();
+        }
+        productDAOs[t] = &db.getDAO<TestProduct>();
+        documentDAOs[t] = &db.getDAO<DocumentRecord>();
+      });
+  }
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  for (int t = 0; t < threadCount; t++)
+  {
+    EXPECT_EQ(productDAOs[t], productDAOs[0]);
+    EXPECT_EQ(documentDAOs[t], documentDAOs[0]);
+  }
+
+  // Nested DAOs created while constructing a DAO are registered too
+  EXPECT_TRUE(db.getDAO<ChildProduct>().isInitialized());
+
+  // Another database gets its own DAOs for the same types
+  cpp_sqlite::Database other{":memory:", true, logger.getLogger()};
+  EXPECT_NE(static_cast<const void*>(&other.getDAO<TestProduct>()),
+            productDAOs[0]);
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, WriteActorBatchesCommandsFromManyThreads)
+{
+  const std::string testDbFile = "test_write_actor.db";
+
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+
+  auto& vertexDAO = db.getDAO<Vertex3D>();
+  ASSERT_TRUE(db.startWriteActor());
+  EXPECT_FALSE(db.startWriteActor());
+
+  int commits = 0;
+  sqlite3_commit_hook(
+    &db.getRawDB(),
+    [](void* pCommits)
+    {
+      ++*static_cast<int*>(pCommits);
+      return 0;
+    },
+    &commits);
+
+  // Hold the actor so that the commands below queue up behind it
+  std::promise<void> gate;
+  std::shared_future<void> opened = gate.get_future().share();
+  auto blocker = db.submitWrite(
+    [opened]
+    {
+      opened.wait();
+      return true;
+    });
+
+  const int threadCount = 4;
+  const int rowsPerThread = 50;
+  std::vector<std::future<bool>> results(threadCount * rowsPerThread);
+  std::vector<std::thread> producers;
+  for (int t = 0; t < threadCount; t++)
+  {
+    producers.emplace_back(
+      [&, t]
+      {
+        for (int i = 0; i < rowsPerThread; i++)
+        {
+          Vertex3D vertex{};
+          vertex.x = static_cast<float>(t);
+          results[t * rowsPerThread + i] =
+            vertexDAO.insertAsync(std::move(vertex));
+        }
+      });
+  }
+  for (auto& producer : producers)
+  {
+    producer.join();
+  }
+
+  // A failing command is rolled back without affecting its batch
+  auto failing = db.submitWrite(
+    [&]
+    {
+      Vertex3D vertex{};
+      vertex.x = -1.0f;
+      vertexDAO.insert(vertex);
+      return false;
+    });
+
+  gate.set_value();
+  EXPECT_TRUE(blocker.get());
+  for (auto& result : results)
+  {
+    EXPECT_TRUE(result.get());
+  }
+  EXPECT_FALSE(failing.get());
+
+  // The queued commands were coalesced into very few transactions
+  EXPECT_LE(commits, 3);
+
+  auto vertices = vertexDAO.selectAll();
+  EXPECT_EQ(vertices.size(), threadCount * rowsPerThread);
+  EXPECT_TRUE(std::ranges::none_of(
+    vertices, [](const Vertex3D& vertex) { return vertex.x < 0.0f; }));
+
+  // Buffered rows are flushed on the actor too
+  Vertex3D buffered{};
+  vertexDAO.addToBuffer(std::move(buffered));
+  db.waitForDurable();
+  EXPECT_EQ(vertexDAO.selectAll().size(), threadCount * rowsPerThread + 1);
+
+  db.startBackgroundWriter();
+  EXPECT_FALSE(db.hasBackgroundWriter());
+
+  db.stopWriteActor();
+  EXPECT_FALSE(db.hasWriteActor());
+
+  CleanUp(testDbFile);
+}
+
+// A minimal fire-and-forget coroutine type, standing in for the task type
+// of whatever event loop the application uses
+struct DetachedTask
+{
+  struct promise_type
+  {
+    DetachedTask get_return_object()
+    {
+      return {};
+    }
+    std::suspend_never initial_suspend() noexcept
+    {
+      return {};
+    }
+    std::suspend_never final_suspend() noexcept
+    {
+      return {};
+    }
+    void return_void()
+    {
+    }
+    void unhandled_exception()
+    {
+      std::terminate();
+    }
+  };
+};
+
+struct CoroutineResults
+{
+  bool inserted{false};
+  std::thread::id resumedOn{};
+  std::optional<Vertex3D> loaded{};
+  bool flushed{false};
+  std::size_t streamed{0};
+};
+
+DetachedTask exerciseVertexDAO(cpp_sqlite::DataAccessObject<Vertex3D>& dao,
+                               CoroutineResults& results,
+                               std::promise<void>& done)
+{
+  Vertex3D vertex{};
+  vertex.x = 1.5f;
+  results.inserted = co_await dao.coInsert(vertex);
+  results.resumedOn = std::this_thread::get_id();
+  results.loaded = co_await dao.coSelectById(1);
+
+  // Enough rows for the cursor to fetch several pages
+  for (int i = 0; i < 600; i++)
+  {
+    dao.addToBuffer(Vertex3D{});
+  }
+  results.flushed = co_await dao.coFlush();
+
+  {
+    // Scoped so that the cursor returns its reader before signalling
+    auto cursor = dao.coSelectAll();
+    while (auto row = co_await cursor.next())
+    {
+      results.streamed++;
+    }
+  }
+
+  done.set_value();
+}
+
+TEST_F(DatabaseTest, CoroutinesAwaitDatabaseWork)
+{
+  const std::string testDbFile = "test_coroutines.db";
+
+  CleanUp(testDbFile);
+  CleanUp(testDbFile + "-wal");
+  CleanUp(testDbFile + "-shm");
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+
+  // Stands in for the application's event loop. It must outlive the
+  // database, which resumes coroutines on it.
+  cpp_sqlite::ThreadPoolExecutor loop{1, logger.getLogger()};
+  std::promise<std::thread::id> loopThread;
+  loop.execute([&] { loopThread.set_value(std::this_thread::get_id()); });
+
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+    auto& vertexDAO = db.getDAO<Vertex3D>();
+
+    // Without an executor the work runs right away
+    EXPECT_TRUE(vertexDAO.coSelectById(1).await_ready());
+
+    ASSERT_TRUE(db.startWriteActor());
+    ASSERT_TRUE(db.openReadPool(2));
+    db.startAsyncExecutor(2, loop.executor());
+    EXPECT_FALSE(vertexDAO.coSelectById(1).await_ready());
+
+    CoroutineResults results;
+    std::promise<void> done;
+    loop.execute([&] { exerciseVertexDAO(vertexDAO, results, done); });
+    done.get_future().wait();
+
+    EXPECT_TRUE(results.inserted);
+    EXPECT_EQ(results.resumedOn, loopThread.get_future().get());
+    ASSERT_TRUE(results.loaded.has_value());
+    EXPECT_FLOAT_EQ(results.loaded->x, 1.5f);
+    EXPECT_TRUE(results.flushed);
+    EXPECT_EQ(results.streamed, 601);
+  }
+
+  CleanUp(testDbFile);
+  CleanUp(testDbFile + "-wal");
+  CleanUp(testDbFile + "-shm");
+}
+
+DetachedTask readVertices(cpp_sqlite::DataAccessObject<Vertex3D>& dao,
+                          uint32_t count,
+                          std::atomic<uint32_t>& found,
+                          std::promise<void>& done)
+{
+  for (uint32_t id = 1; id <= count; id++)
+  {
+    Vertex3D vertex{};
+    vertex.x = static_cast<float>(id);
+    co_await dao.coInsert(vertex);
+
+    if (co_await dao.coSelectById(id))
+    {
+      found++;
+    }
+  }
+  done.set_value();
+}
+
+DetachedTask awaitFailingWork(cpp_sqlite::Database& db,
+                              std::string& error,
+                              std::promise<void>& done)
+{
+  try
+  {
+    co_await db.runAsync<int>([]() -> int
+                              { throw std::runtime_error("work failed"); });
+  }
+  catch (const std::runtime_error& ex)
+  {
+    error = ex.what();
+  }
+  done.set_value();
+}
+
+TEST_F(DatabaseTest, AsyncWorkOnOneConnectionIsSerialized)
+{
+  const std::string testDbFile = "test_async_serialized.db";
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+    auto& vertexDAO = db.getDAO<Vertex3D>();
+
+    // Neither a read pool nor a write actor: every operation uses the
+    // writer connection, from several executor threads
+    db.startAsyncExecutor(4);
+
+    constexpr std::size_t taskCount = 4;
+    constexpr uint32_t rowsPerTask = 50;
+    std::atomic<uint32_t> found{0};
+    std::vector<std::promise<void>> done(taskCount);
+    for (auto& promise : done)
+    {
+      readVertices(vertexDAO, rowsPerTask, found, promise);
+    }
+    for (auto& promise : done)
+    {
+      promise.get_future().wait();
+    }
+
+    EXPECT_EQ(found.load(), taskCount * rowsPerTask);
+    EXPECT_EQ(vertexDAO.selectAll().size(), taskCount * rowsPerTask);
+
+    // A throwing work item fails the awaiting coroutine instead of the
+    // executor thread
+    std::string error;
+    std::promise<void> failed;
+    awaitFailingWork(db, error, failed);
+    failed.get_future().wait();
+    EXPECT_EQ(error, "work failed");
+
+    // The executor and the connection are still usable
+    std::promise<void> after;
+    found = 0;
+    readVertices(vertexDAO, 1, found, after);
+    after.get_future().wait();
+    EXPECT_EQ(found.load(), 1);
+  }
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, DatabaseOptionsAreAppliedAtOpen)
+{
+  const std::string testDbFile = "test_database_options.db";
+
+  CleanUp(testDbFile);
+  CleanUp(testDbFile + "-wal");
+  CleanUp(testDbFile + "-shm");
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  {
+    cpp_sqlite::DatabaseOptions options =
+      cpp_sqlite::DatabaseOptions::fastIngest();
+    options.pageSize = 8192;
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger(), options};
+
+    auto effective = db.effectiveOptions();
+    EXPECT_EQ(effective.journalMode, cpp_sqlite::JournalMode::WAL);
+    EXPECT_EQ(effective.synchronous, cpp_sqlite::SynchronousMode::Normal);
+    EXPECT_EQ(effective.cacheSize, -64 * 1024);
+    EXPECT_EQ(effective.tempStore, cpp_sqlite::TempStore::Memory);
+    EXPECT_EQ(effective.pageSize, 8192);
+    EXPECT_EQ(effective.busyTimeoutMs, 5000);
+
+    // Readers take every setting but the journal mode
+    ASSERT_TRUE(db.openReadPool(1));
+    auto reader = db.leaseReader();
+    ASSERT_TRUE(reader);
+    EXPECT_EQ(reader->effectiveOptions().cacheSize, -64 * 1024);
+    EXPECT_EQ(reader->effectiveOptions().journalMode,
+              cpp_sqlite::JournalMode::WAL);
+  }
+
+  // Without options SQLite's defaults are kept
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+    auto effective = db.effectiveOptions();
+    EXPECT_EQ(effective.synchronous, cpp_sqlite::SynchronousMode::Full);
+    EXPECT_EQ(effective.busyTimeoutMs, 0);
+
+    // WAL mode is a property of the file, so it persists
+    EXPECT_EQ(effective.journalMode, cpp_sqlite::JournalMode::WAL);
+  }
+
+  // An in-memory database cannot use WAL
+  cpp_sqlite::Database memoryDb{":memory:",
+                                true,
+                                logger.getLogger(),
+                                cpp_sqlite::DatabaseOptions::durable()};
+  EXPECT_EQ(memoryDb.effectiveOptions().journalMode,
+            cpp_sqlite::JournalMode::Memory);
+  EXPECT_EQ(memoryDb.effectiveOptions().synchronous,
+            cpp_sqlite::SynchronousMode::Full);
+
+  EXPECT_EQ(cpp_sqlite::DatabaseOptions::readMostly().toString(),
+            "journal_mode=WAL synchronous=1 cache_size=-65536 "
+            "mmap_size=268435456 temp_store=2 busy_timeout=5000");
+
+  CleanUp(testDbFile);
+  CleanUp(testDbFile + "-wal");
+  CleanUp(testDbFile + "-shm");
+}
+
+TEST_F(DatabaseTest, RepeatedFieldsKeepInsertionOrder)
+{
+  const std::string testDbFile = "test_repeated_order.db";
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+    auto& productDAO = db.getDAO<TestProduct>();
+
+    // Unsorted prices, so that ordering by price cannot match insertion
+    // order by accident
+    const std::vector<double> prices{5.0, 1.0, 4.0, 2.0, 3.0};
+    for (int p = 0; p < 3; p++)
+    {
+      TestProduct product;
+      product.name = "ordered";
+      for (double price : prices)
+      {
+        product.children.data.push_back(ChildProduct{{}, price + p});
+      }
+      productDAO.addToBuffer(std::move(product));
+    }
+    ASSERT_TRUE(productDAO.insert().ok());
+
+    // All parents are loaded with one batched junction SELECT
+    const auto products = productDAO.selectAll();
+    ASSERT_EQ(products.size(), 3);
+    const uint32_t firstId =
+      std::ranges::min(products, {}, &TestProduct::id).id;
+    for (const auto& product : products)
+    {
+      const auto offset = static_cast<double>(product.id - firstId);
+      ASSERT_EQ(product.children.data.size(), prices.size());
+      for (std::size_t i = 0; i < prices.size(); i++)
+      {
+        EXPECT_DOUBLE_EQ(product.children.data[i].price, prices[i] + offset);
+      }
+    }
+  }
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, SharedNestedObjectsAllGetRepeatedFields)
+{
+  const std::string testDbFile = "test_shared_nested.db";
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+    auto& assemblyDAO = db.getDAO<Assembly>();
+
+    Assembly assembly;
+    assembly.label = "first";
+    assembly.product.name = "shared";
+    assembly.product.children.data = {ChildProduct{{}, 1.5},
+                                      ChildProduct{{}, 2.5}};
+    ASSERT_TRUE(assemblyDAO.insert(assembly));
+
+    // A second row that points at the same nested product
+    ASSERT_EQ(sqlite3_exec(&db.getRawDB(),
+                           "INSERT INTO Assembly "
+                           "(id, label, body_id, product_id) "
+                           "SELECT id + 100, 'second', body_id, product_id "
+                           "FROM Assembly;",
+                           nullptr,
+                           nullptr,
+                           nullptr),
+              SQLITE_OK);
+
+    const auto assemblies = assemblyDAO.selectAll();
+    ASSERT_EQ(assemblies.size(), 2);
+    for (const auto& loaded : assemblies)
+    {
+      EXPECT_EQ(loaded.product.id, assembly.product.id);
+      ASSERT_EQ(loaded.product.children.data.size(), 2);
+      EXPECT_DOUBLE_EQ(loaded.product.children.data[0].price, 1.5);
+      EXPECT_DOUBLE_EQ(loaded.product.children.data[1].price, 2.5);
+    }
+  }
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, StatementsAreGeneratedAtCompileTime)
+{
+  using RigidBodySQL = cpp_sqlite::TableSQL<RigidBody>;
+
+  static_assert(cpp_sqlite::sqlTableName<my_app::NamespacedProduct> ==
+                "NamespacedProduct");
+  static_assert(RigidBodySQL::insert.view() ==
+                "INSERT INTO RigidBody (id, name, mass, centerOfMass_id, "
+                "initialPosition_id) VALUES (?, ?, ?, ?, ?);");
+  static_assert(RigidBodySQL::selectById.view() ==
+                "SELECT t0.id, t0.name, t0.mass, t0.centerOfMass_id, "
+                "t0.initialPosition_id, t1.id, t1.x, t1.y, t1.z FROM "
+                "RigidBody t0 LEFT JOIN Vertex3D t1 ON t1.id = "
+                "t0.initialPosition_id WHERE t0.id = ?;");
+  static_assert(cpp_sqlite::JunctionSQL<TestProduct, ChildProduct>::insert
+                  .view() == "INSERT INTO TestProduct_ChildProduct("
+                             "TestProduct_id, ChildProduct_id) VALUES (?, ?);");
+  static_assert(
+    cpp_sqlite::JunctionSQL<TestProduct, ChildProduct>::selectSuffix.view() ==
+    ") ORDER BY j.TestProduct_id, j.ChildProduct_id;");
+
+  EXPECT_EQ(RigidBodySQL::createTable.view(),
+            "CREATE TABLE IF NOT EXISTS RigidBody (id INTEGER PRIMARY KEY, "
+            "name TEXT, mass FLOAT, centerOfMass_id INTEGER, "
+            "initialPosition_id INTEGER, FOREIGN KEY (centerOfMass_id) "
+            "REFERENCES Vertex3D(id), FOREIGN KEY (initialPosition_id) "
+            "REFERENCES Vertex3D(id));");
+
+  // The generated schema is what the DAO creates
+  const std::string testDbFile = "test_static_sql.db";
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+    ASSERT_TRUE(db.getDAO<RigidBody>().isInitialized());
+
+    cpp_sqlite::PreparedSQLStmt stmt{nullptr, sqlite3_finalize};
+    sqlite3_stmt* raw = nullptr;
+    ASSERT_EQ(sqlite3_prepare_v2(&db.getRawDB(),
+                                 "SELECT sql FROM sqlite_master WHERE name = "
+                                 "'RigidBody';",
+                                 -1,
+                                 &raw,
+                                 nullptr),
+              SQLITE_OK);
+    stmt.reset(raw);
+    ASSERT_EQ(sqlite3_step(stmt.get()), SQLITE_ROW);
+    std::string storedSQL =
+      reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 0));
+    // SQLite stores the statement without IF NOT EXISTS
+    EXPECT_EQ("CREATE TABLE IF NOT EXISTS " + storedSQL.substr(13) + ";",
+              RigidBodySQL::createTable.view());
+  }
+
+  CleanUp(testDbFile);
+}
+
+namespace my_app
+{
+
+struct Catalog : public cpp_sqlite::BaseTransferObject
+{
+  std::string title;
+  cpp_sqlite::RepeatedFieldTransferObject<ChildProduct> products;
+};
+
+BOOST_DESCRIBE_STRUCT(Catalog,
+                      (cpp_sqlite::BaseTransferObject),
+                      (title, products));
+CPP_SQLITE_TABLE_NAME(Catalog, "catalogs");
+
+}  // namespace my_app
+
+TEST_F(DatabaseTest, TableNamesAreCompileTimeConstants)
+{
+  static_assert(cpp_sqlite::DataAccessObject<TestProduct>::tableName ==
+                "TestProduct");
+  static_assert(cpp_sqlite::sqlTableName<my_app::Catalog> == "catalogs");
+  static_assert(
+    cpp_sqlite::JunctionSQL<my_app::Catalog, ChildProduct>::tableName.view() ==
+    "catalogs_ChildProduct");
+  static_assert(!cpp_sqlite::HasTableNameOverride<TestProduct>);
+
+  const std::string testDbFile = "test_table_names.db";
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+    auto& catalogDAO = db.getDAO<my_app::Catalog>();
+    ASSERT_TRUE(catalogDAO.isInitialized());
+    EXPECT_EQ(catalogDAO.getTableName(), "catalogs");
+    EXPECT_TRUE(catalogDAO.createJunctionReverseIndexes());
+
+    my_app::Catalog catalog;
+    catalog.title = "Spring";
+    catalog.products.data = {ChildProduct{{}, 1.5}, ChildProduct{{}, 2.5}};
+    ASSERT_TRUE(catalogDAO.insert(catalog));
+
+    auto loaded = catalogDAO.selectById(catalog.id);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->title, "Spring");
+    ASSERT_EQ(loaded->products.data.size(), 2);
+    EXPECT_DOUBLE_EQ(loaded->products.data[1].price, 2.5);
+
+    // Writes to the renamed table still reach its select cache
+    auto cached = catalogDAO.selectCacheById(catalog.id);
+    ASSERT_TRUE(cached);
+    sqlite3_exec(&db.getRawDB(),
+                 "UPDATE catalogs SET title = 'Autumn';",
+                 nullptr,
+                 nullptr,
+                 nullptr);
+    EXPECT_EQ(catalogDAO.selectCacheById(catalog.id)->title, "Autumn");
+  }
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, StatementMetricsAreRecordedWhenEnabled)
+{
+  using cpp_sqlite::LatencyHistogram;
+  using cpp_sqlite::StatementKind;
+
+  // Every latency falls into the bucket whose bounds enclose it
+  for (uint64_t nanos : {0ull, 7ull, 8ull, 9ull, 1000ull, 123456789ull})
+  {
+    const std::size_t index = LatencyHistogram::bucketIndex(nanos);
+    EXPECT_LE(LatencyHistogram::bucketLowerBound(index), nanos);
+    EXPECT_GT(LatencyHistogram::bucketLowerBound(index + 1), nanos);
+  }
+
+  const std::string testDbFile = "test_statement_metrics.db";
+  const std::string metricsFile = "test_statement_metrics.prom";
+  CleanUp(testDbFile);
+  CleanUp(metricsFile);
+
+  auto makeProduct = [](const std::string& name)
+  {
+    TestProduct product;
+    product.name = name;
+    product.price = 1.0f;
+    product.quantity = 1;
+    product.in_stock = true;
+    product.children.data = {ChildProduct{{}, 1.5}, ChildProduct{{}, 2.5}};
+    return product;
+  };
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+    auto& productDAO = db.getDAO<TestProduct>();
+
+    // Nothing is recorded until metrics are enabled
+    TestProduct first = makeProduct("first");
+    ASSERT_TRUE(productDAO.insert(first));
+    EXPECT_FALSE(db.metricsEnabled());
+    EXPECT_TRUE(db.metrics().statements.empty());
+
+    db.enableMetrics();
+    EXPECT_TRUE(db.metricsEnabled());
+
+    for (int i = 0; i < 3; i++)
+    {
+      productDAO.addToBuffer(makeProduct("buffered"));
+    }
+    ASSERT_TRUE(productDAO.insert().ok());
+    ASSERT_EQ(productDAO.selectAll().size(), 4);
+    ASSERT_TRUE(productDAO.selectById(first.id).has_value());
+
+    const auto snapshot = db.metrics();
+    constexpr std::string_view junctionTable =
+      cpp_sqlite::JunctionSQL<TestProduct, ChildProduct>::tableName;
+
+    const auto* inserts = snapshot.find("TestProduct", StatementKind::Insert);
+    ASSERT_NE(inserts, nullptr);
+    EXPECT_EQ(inserts->calls, 3);
+    EXPECT_EQ(inserts->rows, 3);
+
+    const auto* childInserts =
+      snapshot.find("ChildProduct", StatementKind::Insert);
+    ASSERT_NE(childInserts, nullptr);
+    EXPECT_EQ(childInserts->calls, 6);
+
+    const auto* links =
+      snapshot.find(junctionTable, StatementKind::JunctionInsert);
+    ASSERT_NE(links, nullptr);
+    EXPECT_EQ(links->rows, 6);
+
+    const auto* selectAll =
+      snapshot.find("TestProduct", StatementKind::SelectAll);
+    ASSERT_NE(selectAll, nullptr);
+    EXPECT_EQ(selectAll->calls, 1);
+    EXPECT_EQ(selectAll->rows, 4);
+
+    const auto* selectById =
+      snapshot.find("TestProduct", StatementKind::SelectById);
+    ASSERT_NE(selectById, nullptr);
+    EXPECT_EQ(selectById->calls, 1);
+    EXPECT_EQ(selectById->rows, 1);
+
+    // The children of both selects were loaded through the junction table
+    const auto* childLoads =
+      snapshot.find(junctionTable, StatementKind::JunctionSelect);
+    ASSERT_NE(childLoads, nullptr);
+    EXPECT_EQ(childLoads->calls, 2);
+    EXPECT_EQ(childLoads->rows, 10);
+
+    const auto& latency = inserts->latency;
+    EXPECT_EQ(latency.count, 3);
+    EXPECT_GT(latency.percentile(0.5), 0);
+    EXPECT_LE(latency.percentile(0.5), latency.percentile(0.99));
+    EXPECT_LE(latency.percentile(0.99), latency.maxNanos);
+
+    // Metrics are kept, but no longer updated, once disabled
+    db.enableMetrics(false);
+    EXPECT_FALSE(db.metricsEnabled());
+    productDAO.selectAll();
+    EXPECT_EQ(
+      db.metrics().find("TestProduct", StatementKind::SelectAll)->calls, 1);
+
+    std::string exported;
+    db.exportMetrics([&exported](std::string_view text) { exported = text; });
+    EXPECT_NE(exported.find("# TYPE cpp_sqlite_statement_duration_seconds "
+                            "histogram\n"),
+              std::string::npos);
+    EXPECT_NE(exported.find("cpp_sqlite_statement_calls_total{table="
+                            "\"TestProduct\",statement=\"select_all\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(exported.find("cpp_sqlite_statement_duration_seconds_bucket{"
+                            "table=\"TestProduct\",statement=\"insert\","
+                            "le=\"+Inf\"} 3\n"),
+              std::string::npos);
+
+    ASSERT_TRUE(db.exportMetrics(metricsFile));
+    std::ifstream file{metricsFile};
+    std::stringstream contents;
+    contents << file.rdbuf();
+    EXPECT_EQ(contents.str(), exported);
+  }
+
+  CleanUp(testDbFile);
+  CleanUp(metricsFile);
+}
+
+TEST_F(DatabaseTest, SlowQueriesAreCapturedAboveThreshold)
+{
+  using namespace std::chrono_literals;
+
+  const std::string testDbFile = "test_slow_queries.db";
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+    auto& productDAO = db.getDAO<TestProduct>();
+
+    TestProduct product;
+    product.name = "slow";
+    product.price = 1.0f;
+    product.quantity = 1;
+    product.in_stock = true;
+    ASSERT_TRUE(productDAO.insert(product));
+    EXPECT_TRUE(db.slowQueries().empty());
+
+    // With no threshold, every statement is slow
+    constexpr std::size_t capacity = 4;
+    db.enableSlowQueryLog(0ns, capacity);
+    ASSERT_TRUE(productDAO.selectById(product.id).has_value());
+
+    const auto queries = db.slowQueries();
+    const std::string boundId = std::to_string(product.id);
+    auto it = std::ranges::find_if(
+      queries,
+      [](const cpp_sqlite::SlowQuery& query)
+      { return query.statement == "SELECT BY ID"; });
+    ASSERT_NE(it, queries.end());
+    EXPECT_EQ(it->table, "TestProduct");
+    EXPECT_NE(it->sql.find(boundId), std::string::npos);
+    EXPECT_GE(it->duration, 0ns);
+    EXPECT_NE(db.dumpSlowQueries().find(" ms [TestProduct SELECT BY ID] "),
+              std::string::npos);
+
+    // Only the most recent statements are kept. Loading the children of a
+    // product goes through its junction table.
+    for (int i = 0; i < 10; i++)
+    {
+      productDAO.selectById(product.id);
+    }
+    const auto recent = db.slowQueries();
+    ASSERT_EQ(recent.size(), capacity);
+    EXPECT_EQ(recent.back().statement, "junction select");
+    constexpr std::string_view junctionTable =
+      cpp_sqlite::JunctionSQL<TestProduct, ChildProduct>::tableName;
+    EXPECT_EQ(recent.back().table, junctionTable);
+
+    // Nothing is this slow
+    db.enableSlowQueryLog(1h, capacity);
+    productDAO.selectAll();
+    EXPECT_EQ(db.slowQueries().back().sql, recent.back().sql);
+    EXPECT_EQ(db.slowQueries().size(), capacity);
+
+    // Captured statements are kept once disabled
+    db.enableSlowQueryLog(0ns, capacity);
+    db.disableSlowQueryLog();
+    productDAO.selectAll();
+    EXPECT_EQ(db.slowQueries().back().sql, recent.back().sql);
+  }
+
+  CleanUp(testDbFile);
+}
+
+TEST_F(DatabaseTest, LogCallsBelowActiveLevelAreStripped)
+{
+  auto pLogger = std::make_shared<spdlog::logger>(
+    "strip_test", std::make_shared<spdlog::sinks::null_sink_mt>());
+  pLogger->set_level(spdlog::level::trace);
+
+  // The arguments of stripped calls are never evaluated
+  for (auto level : {spdlog::level::trace,
+                     spdlog::level::debug,
+                     spdlog::level::info,
+                     spdlog::level::warn,
+                     spdlog::level::err,
+                     spdlog::level::critical})
+  {
+    int evaluated = 0;
+    LOG_SAFE(pLogger, level, "{}", ++evaluated);
+    EXPECT_EQ(evaluated, level >= CPP_SQLITE_ACTIVE_LOG_LEVEL ? 1 : 0);
+  }
+
+  const std::string testDbFile = "test_async_logger.db";
+  const std::string logFile = "test_async_logger.log";
+  CleanUp(testDbFile);
+
+  auto& logger = cpp_sqlite::Logger::getInstance();
+  logger.configure("cpp_sqlite_async",
+                   logFile,
+                   spdlog::level::debug,
+                   cpp_sqlite::Logger::Mode::Async);
+  ASSERT_NE(
+    std::dynamic_pointer_cast<spdlog::async_logger>(logger.getLogger()),
+    nullptr);
+  {
+    cpp_sqlite::Database db{testDbFile, true, logger.getLogger()};
+    auto& productDAO = db.getDAO<TestProduct>();
+
+    TestProduct product;
+    product.name = "async";
+    product.price = 1.0f;
+    product.quantity = 1;
+    product.in_stock = true;
+    ASSERT_TRUE(productDAO.insert(product));
+    EXPECT_TRUE(productDAO.selectById(product.id).has_value());
+  }
+
+  // Restore the default synchronous logger for the other tests
+  logger.configure();
+  EXPECT_EQ(
+    std::dynamic_pointer_cast<spdlog::async_logger>(logger.getLogger()),
+    nullptr);
+
+  CleanUp(testDbFile);
+  CleanUp(logFile);
+}
@@ -0,0 +1,66 @@
+#ifndef TEST_TRANSFER_OBJECTS_HPP
+#define TEST_TRANSFER_OBJECTS_HPP
+
+#include <string>
+
+#include <boost/describe.hpp>
+#include <boost/describe/class.hpp>
+
+#include "cpp_sqlite/src/cpp_sqlite/DBBaseTransferObject.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBForeignKey.hpp"
+#include "cpp_sqlite/src/cpp_sqlite/DBRepeatedFieldTransferObject.hpp"
+
+// Transfer objects shared by the test suite and the benchmarks: a flat
+// type, a type with a nested object and a foreign key, and a type with a
+// repeated field
+
+struct ChildProduct : public cpp_sqlite::BaseTransferObject
+{
+  double price;
+};
+
+
+BOOST_DESCRIBE_STRUCT(ChildProduct, (cpp_sqlite::BaseTransferObject), (price));
+
+BOOST_DESCRIBE_STRUCT(cpp_sqlite::RepeatedFieldTransferObject<ChildProduct>,
+                      (),
+                      (data));
+
+// Test TransferObject class for demonstration
+struct TestProduct : public cpp_sqlite::BaseTransferObject
+{
+  std::string name;
+  float price;
+  int quantity;
+  bool in_stock;
+  cpp_sqlite::RepeatedFieldTransferObject<ChildProduct> children;
+};
+
+// Register the test class with boost::describe
+BOOST_DESCRIBE_STRUCT(TestProduct,
+                      (cpp_sqlite::BaseTransferObject),
+                      (name, price, quantity, in_stock, children));
+
+// Test structures for ForeignKey
+struct Vertex3D : public cpp_sqlite::BaseTransferObject
+{
+  float x;
+  float y;
+  float z;
+};
+
+BOOST_DESCRIBE_STRUCT(Vertex3D, (cpp_sqlite::BaseTransferObject), (x, y, z));
+
+struct RigidBody : public cpp_sqlite::BaseTransferObject
+{
+  std::string name;
+  float mass;
+  cpp_sqlite::ForeignKey<Vertex3D> centerOfMass;  // Lazy FK
+  Vertex3D initialPosition;                       // Eager load
+};
+
+BOOST_DESCRIBE_STRUCT(RigidBody,
+                      (cpp_sqlite::BaseTransferObject),
+                      (name, mass, centerOfMass, initialPosition));
+
+#endif  // TEST_TRANSFER_OBJECTS_HPP